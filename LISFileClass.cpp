@@ -1,6 +1,84 @@
 #include "StdAfx.h"
 #include ".\lisfileclass.h"
+#include "LisReprCode.h"
+#include "LisDatWriter.h"
+#include "LisColumnFile.h"
+#include "LisParallel.h"
+#include "LisIndexCache.h"
+#include "LisFileType.h"
 #include <math.h>
+#include <limits.h>
+
+//Cac section trong file chi muc (.lidx)
+#define		LIS_IDXTAG_INFO		1//nFileType
+#define		LIS_IDXTAG_PR		3//PhysicalRecord
+#define		LIS_IDXTAG_DEPTH	4//LISDepthEntry cua Logical File mac dinh
+#define		LIS_IDXTAG_LRLEN	5//Cac cot cua LogicalRecordIndex
+#define		LIS_IDXTAG_LRADDR	6
+#define		LIS_IDXTAG_LRTYPE	7
+#define		LIS_IDXTAG_LRPRSTART	8//nCount+1 phan tu
+
+//Tang gap doi kich thuoc mang chi muc (index array grows geometrically)
+template<class T> static void GrowIndexArray(T*& pArr, int nCount, int& nCapacity)
+{
+	int		nNewCapacity = nCapacity * 2;
+	T*		pNewArr = new T[nNewCapacity];
+
+	memcpy(pNewArr, pArr, nCount * sizeof(T));
+	delete[] pArr;
+
+	pArr = pNewArr;
+	nCapacity = nNewCapacity;
+}
+
+//////////////////////////////////////////////////////////////////////
+// LogicalRecordIndex
+//////////////////////////////////////////////////////////////////////
+
+//Cap phat lai khoi cot voi nNewCapacity LR (giu nCount LR da co)
+void LogicalRecordIndex::SetCapacity(int nNewCapacity)
+{
+	int			nBlockSize = nNewCapacity * (2*sizeof(__int64) + sizeof(int)) + (nNewCapacity + 1) * sizeof(int);
+	BYTE*		pNewBlock = new BYTE[nBlockSize];
+	__int64*	pNewLen = (__int64*)pNewBlock;
+	__int64*	pNewAddress = pNewLen + nNewCapacity;
+	int*	pNewType = (int*)(pNewAddress + nNewCapacity);
+	int*	pNewPRStart = pNewType + nNewCapacity;
+
+	if(this->pBlock != NULL)
+	{
+		memcpy(pNewLen, this->pLen, this->nCount * sizeof(__int64));
+		memcpy(pNewAddress, this->pAddress, this->nCount * sizeof(__int64));
+		memcpy(pNewType, this->pType, this->nCount * sizeof(int));
+		memcpy(pNewPRStart, this->pPRStart, this->nCount * sizeof(int));
+		delete[] this->pBlock;
+	}
+
+	this->pBlock = pNewBlock;
+	this->pLen = pNewLen;
+	this->pAddress = pNewAddress;
+	this->pType = pNewType;
+	this->pPRStart = pNewPRStart;
+	this->nCapacity = nNewCapacity;
+}
+
+void LogicalRecordIndex::Free()
+{
+	if(this->pBlock != NULL)
+		delete[] this->pBlock;
+	Detach();
+}
+
+void LogicalRecordIndex::Detach()
+{
+	this->pBlock = NULL;
+	this->pLen = NULL;
+	this->pAddress = NULL;
+	this->pType = NULL;
+	this->pPRStart = NULL;
+	this->nCount = 0;
+	this->nCapacity = 0;
+}
 
 int LISMisc::GetReprCodeSize(int nReprCode)
 {
@@ -67,7 +145,13 @@ CString LISMisc::FindLogicalRecordTypeName(int nType)
 }
 double LISMisc::ConvertDepthValue(double fDepth, CString strOldDU, CString strNewDU)
 {
-	double fDepth1 = fDepth;
+	return GetDepthUnit(strOldDU, strNewDU).Convert(fDepth);
+}
+
+//Phan tich don vi do sau mot lan; Convert() cho ket qua nhu ConvertDepthValue
+DepthUnit_t LISMisc::GetDepthUnit(CString strOldDU, CString strNewDU)
+{
+	DepthUnit_t	unit;
     //m,dm, cm, mm, in, ft
     // 1 in = 2.54 cm
     // 1 foot = 30.48 centimeters
@@ -97,20 +181,22 @@ double LISMisc::ConvertDepthValue(double fDepth, CString strOldDU, CString strNe
 
     if (strNewDU == "m")
     {
-        if (strOldDU == "m") return fFactor * fDepth;
-        else if (strOldDU == "dm") return fFactor * fDepth * 0.1;
-        else if (strOldDU == "cm") return fFactor * fDepth * 0.01;
-        else if (strOldDU == "mm") return fFactor * fDepth * 0.001;
-        else if (strOldDU == "in") return fFactor * fDepth * 0.0254;
-        else if (strOldDU == "ft") return fFactor * fDepth * 0.3048;
+        if (strOldDU == "m") unit.fScale = 1;
+        else if (strOldDU == "dm") unit.fScale = 0.1;
+        else if (strOldDU == "cm") unit.fScale = 0.01;
+        else if (strOldDU == "mm") unit.fScale = 0.001;
+        else if (strOldDU == "in") unit.fScale = 0.0254;
+        else if (strOldDU == "ft") unit.fScale = 0.3048;
+        else return unit;
+
+        unit.fFactor = fFactor;
     }
 
-    return fDepth1;
-	
+    return unit;
 }
 
-int LISMisc::ReadReprCode(BYTE byteArr[], int nCount, int nReprCode,
-                 ReprCodeReturn& ret, int& nRealSize, int nCurPos)
+int LISMisc::ReadReprCode(const BYTE byteArr[], int nCount, int nReprCode,
+                 ReprCodeReturn& ret, int& nRealSize, int nCurPos, bool bShowError)
 {
 	//nType //1=Integer; 2=double; 3=string
 
@@ -177,7 +263,21 @@ int LISMisc::ReadReprCode(BYTE byteArr[], int nCount, int nReprCode,
         ret.nType = 2; //double;
 
         nRealSize = 4;
-	
+
+        byte1 = byteArr[0 + nCurPos];
+        byte2 = byteArr[1 + nCurPos];
+        byte3 = byteArr[2 + nCurPos];
+        byte4 = byteArr[3 + nCurPos];
+
+        //2 byte dau: so mu E (2's complement), 2 byte sau: phan dinh tri M (2's complement)
+        //Gia tri = M/2^15 * 2^E
+        int E = (short)((byte1 << 8) | byte2);
+        int M = (short)((byte3 << 8) | byte4);
+
+        ret.fValue = ldexp((double)M, E - 15);
+
+		ret.nValue = ret.fValue;
+
         return 1;
     }
 
@@ -222,7 +322,7 @@ int LISMisc::ReadReprCode(BYTE byteArr[], int nCount, int nReprCode,
             if (byteArr[i+nCurPos] == 0) nCount1--;
 
         //string sStr = Encoding.UTF8.GetString(byteArr, nCurPos, nCount1);
-		CString sStr((char*)(byteArr+nCurPos), nCount1);
+		CString sStr((const char*)(byteArr+nCurPos), nCount1);
 
         ret.strValue = sStr;
 		ret.strValue.Trim();
@@ -310,6 +410,28 @@ int LISMisc::ReadReprCode(BYTE byteArr[], int nCount, int nReprCode,
         return 1;
     }
 	
+	//REPRCODE_70 - 32 bit fix point (16 bit nguyen, 16 bit le)
+    if (nReprCode == REPRCODE_70)
+    {
+        ret.nType = 2; //double;
+
+        nRealSize = 4;
+
+        byte1 = byteArr[0 + nCurPos];
+        byte2 = byteArr[1 + nCurPos];
+        byte3 = byteArr[2 + nCurPos];
+        byte4 = byteArr[3 + nCurPos];
+
+        int nFixed = (int)(((unsigned int)byte1 << 24) | ((unsigned int)byte2 << 16) |
+                            ((unsigned int)byte3 << 8) | (unsigned int)byte4);
+
+        ret.fValue = nFixed / 65536.0;
+
+		ret.nValue = ret.fValue;
+
+        return 1;
+    }
+
 	//REPRCODE_73 - 2's completement 32 bit integer;
     if (nReprCode == REPRCODE_73)//unsigned 8-bit integer
     {
@@ -385,7 +507,8 @@ int LISMisc::ReadReprCode(BYTE byteArr[], int nCount, int nReprCode,
         return 1;
     }
 
-	AfxMessageBox("Read Repr. Code");
+	if(bShowError)
+		AfxMessageBox("Read Repr. Code");
 	return 0;
 }
 
@@ -411,13 +534,30 @@ LISFileClass::LISFileClass(void)
 	this->hFile = NULL;
 	this->nFileSize = 0;
 
-	this->lrArr = NULL;
 	this->nLogicalRecordNum = 0;
+	this->prTable = NULL;
+	this->nPhysicalRecordNum = 0;
 
 	this->nLogicalFileNum = 0;
+	this->nFirstIFLR1 = -1;
+	this->nEndIFLR1 = -1;
 	this->pBytesBuf = NULL;
+	this->pLogRecBytes = NULL;
+
+	this->bUseMappedFile = false;
+	this->bUseIndexCache = false;
+	this->nDecodeThreadNum = 0;
+	this->bShowErrors = true;
+	this->bDecodeError = false;
+	this->nPipelineDepth = LIS_PIPELINE_DEPTH;
+
+	this->pIndexSource = NULL;
+	this->strDATPrefix = "";
+	this->bColumnOutput = false;
+	this->bSelectiveLoad = false;
 
 	this->progressBar = NULL;
+	this->mappedFile.pPerfStats = &this->perfStats;
 }
 
 LISFileClass::~LISFileClass(void)
@@ -428,7 +568,7 @@ LISFileClass::~LISFileClass(void)
 
 int LISFileClass::GetNextPR(int nLRNum, int nCurIdx1, int nCurIdx2, int& nNextIdx1, int& nNextIdx2)
 {
-	if (nCurIdx2 < lrArr[nCurIdx1].nPhysicalRecordNum - 1)
+	if (nCurIdx2 < GetPRNum(nCurIdx1) - 1)
     {
         nNextIdx1 = nCurIdx1;
         nNextIdx2 = nCurIdx2 + 1;
@@ -436,7 +576,7 @@ int LISFileClass::GetNextPR(int nLRNum, int nCurIdx1, int nCurIdx2, int& nNextId
     }
     else
     {
-        if ((nCurIdx1 >= nLRNum - 1) && (nCurIdx2 >= lrArr[nCurIdx1].nPhysicalRecordNum - 1))
+        if ((nCurIdx1 >= nLRNum - 1) && (nCurIdx2 >= GetPRNum(nCurIdx1) - 1))
             return 0;
 
         nNextIdx1 = nCurIdx1 + 1;
@@ -460,7 +600,7 @@ int LISFileClass::GetPrevPR(int nCurIdx1, int nCurIdx2, int& nPrevIdx1, int& nPr
             return 0;
 
         nPrevIdx1 = nCurIdx1 - 1;
-        nPrevIdx2 = lrArr[nCurIdx1 - 1].nPhysicalRecordNum - 1;
+        nPrevIdx2 = GetPRNum(nCurIdx1 - 1) - 1;
         return 1;
     }
 	return 0;
@@ -509,22 +649,31 @@ void LISFileClass::ReleaseResources(void)
 		hFile = NULL;
 	}
 
+	this->mappedFile.Close();
+
 	if(this->pBytesBuf != NULL)
 	{
 		delete[] this->pBytesBuf;
 		this->pBytesBuf = NULL;
 	}
+	this->pLogRecBytes = NULL;
 	
-	for(int i = 0; i<this->nLogicalRecordNum;i++)
+	//Chi muc muon cua doi tuong goc: khong giai phong
+	if(this->pIndexSource != NULL)
 	{
-		if(this->lrArr[i].prArr != NULL)
-		{
-			delete[] this->lrArr[i].prArr;
-			this->lrArr[i].prArr = NULL;
-		}
+		this->prTable = NULL;
+		this->lrIndex.Detach();
+		this->pIndexSource = NULL;
+	}
+
+	if(this->prTable != NULL)
+	{
+		delete[] this->prTable;
+		this->prTable = NULL;
 	}
-	delete[] this->lrArr;
-	this->lrArr = NULL;
+	this->nPhysicalRecordNum = 0;
+
+	this->lrIndex.Free();
 	
 	//chansArr.RemoveAll();
 	this->ReleaseChansArr();
@@ -532,11 +681,16 @@ void LISFileClass::ReleaseResources(void)
 	ReleaseDATASETArr();
 
 	this->ReleaseEFLRArr(true);
+	this->depthIndex.RemoveAll();
+	this->cachedDepthArr.RemoveAll();
 
 	//stepArr.RemoveAll();
 
-	for(int i = 0; i<this->nLogicalFileNum; i++)
-		this->logicalFileArr[i].ReleaseResources();
+	this->logicalFileArr.RemoveAll();
+	this->eflrIdxArr.RemoveAll();
+	this->nLogicalFileNum = 0;
+	this->nFirstIFLR1 = -1;
+	this->nEndIFLR1 = -1;
 }
 void LISFileClass::ReleaseChansArr(void)
 {
@@ -547,9 +701,12 @@ void LISFileClass::ReleaseChansArr(void)
 			chansArr[i].fData = NULL;
 		}
 	chansArr.RemoveAll();
+	framePlanArr.RemoveAll();
 }
 double LISFileClass::GetStartDepth(void)
 {
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_DEPTH);
+
 	double fDepth = -1;
     BYTE byteArr[100];
     int nReprCode;
@@ -565,25 +722,21 @@ double LISFileClass::GetStartDepth(void)
         nReprCode = this->entryBlock.nDepthRepr;
     }
 
-	fseek(hFile, lrArr[this->nFirstIFLR1].lAddress + 6 ,SEEK_SET);
-	fread(byteArr, sizeof(BYTE), LISMisc::GetReprCodeSize(nReprCode),hFile);
+	this->ReadFileBytes(lrIndex.pAddress[this->nFirstIFLR1] + 6, byteArr, LISMisc::GetReprCodeSize(nReprCode));
     //hFile.BaseStream.Seek(lrArr[this.nFirstIFLR1].lAddress + 6, SeekOrigin.Begin);
     //hFile.Read(byteArr, 0, Misc.GetReprCodeSize(nReprCode));
 
-	LISMisc::ReadReprCode(byteArr, LISMisc::GetReprCodeSize(nReprCode), nReprCode, ret, nRealSize);
+	this->ReadReprCode(byteArr, LISMisc::GetReprCodeSize(nReprCode), nReprCode, ret, nRealSize);
 
-    fDepth = ret.fValue;
-
-    if (this->entryBlock.nDepthRecordingMode == 0)//Depth per frame
-		fDepth = LISMisc::ConvertDepthValue(fDepth, this->chansArr[nDepthCurveIdx].strUnits, "m");
-    else//Depth per record
-		fDepth = LISMisc::ConvertDepthValue(fDepth, this->entryBlock.strDepthUnit, "m");
+    fDepth = this->depthUnit.Convert(ret.fValue);
 
     return fDepth;
 }
 
 double LISFileClass::GetEndDepth(double fStep)
 {
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_DEPTH);
+
 	double fDepth = -1;
     BYTE byteArr[100];
     int nReprCode;
@@ -602,21 +755,15 @@ double LISFileClass::GetEndDepth(double fStep)
 		nExtraBytes += LISMisc::GetReprCodeSize(nReprCode);
     }
 
-	fseek(hFile, lrArr[this->nEndIFLR1].lAddress + 6 ,SEEK_SET);
-	fread(byteArr, sizeof(BYTE), LISMisc::GetReprCodeSize(nReprCode),hFile);
+	this->ReadFileBytes(lrIndex.pAddress[this->nEndIFLR1] + 6, byteArr, LISMisc::GetReprCodeSize(nReprCode));
     //hFile.BaseStream.Seek(lrArr[this.nEndIFLR1].lAddress + 6, SeekOrigin.Begin);
     //hFile.Read(byteArr, 0, Misc.GetReprCodeSize(nReprCode));
 
-	LISMisc::ReadReprCode(byteArr, LISMisc::GetReprCodeSize(nReprCode), nReprCode, ret, nRealSize);
-
-    fDepth = ret.fValue;
+	this->ReadReprCode(byteArr, LISMisc::GetReprCodeSize(nReprCode), nReprCode, ret, nRealSize);
 
-    if (this->entryBlock.nDepthRecordingMode == 0)//Depth per frame
-		fDepth = LISMisc::ConvertDepthValue(fDepth, this->chansArr[nDepthCurveIdx].strUnits, "m");
-    else//Depth per record
-		fDepth = LISMisc::ConvertDepthValue(fDepth, this->entryBlock.strDepthUnit, "m");
+    fDepth = this->depthUnit.Convert(ret.fValue);
 
-    int nFrameNum = ((int)lrArr[this->nEndIFLR1].lLen - nExtraBytes) / this->nFrameSizeInBytes;
+    int nFrameNum = ((int)lrIndex.pLen[this->nEndIFLR1] - nExtraBytes) / this->nFrameSizeInBytes;
 
     if (this->entryBlock.nDirection == 255)//Down
     {
@@ -634,17 +781,50 @@ int LISFileClass::GetExtraBytesInLogRec(int nLRIdx)
 {
 	int n = 6;
 
-    n += (this->lrArr[nLRIdx].nPhysicalRecordNum - 1) * 4;
+    n += (this->GetPRNum(nLRIdx) - 1) * 4;
 
     return n;
 }
-int LISFileClass::ReadLogRecBytes(int nLRIdx)
+//Doc nCount byte tai vi tri lAddr (tu vung anh xa neu co: chi mo
+//duoc voi file < 2 GB, nen lAddr vua long)
+void LISFileClass::ReadFileBytes(__int64 lAddr, BYTE* pDst, int nCount)
+{
+	if(this->mappedFile.IsOpen())
+	{
+		this->mappedFile.Read((long)lAddr, pDst, nCount);
+		return;
+	}
+
+	_fseeki64(hFile, lAddr, SEEK_SET);
+	this->perfStats.AddSeek();
+	this->perfStats.AddRead((LONGLONG)fread(pDst, sizeof(BYTE), nCount, hFile));
+}
+
+//LISMisc::ReadReprCode tren doi tuong nay: ma khong ho tro -> bDecodeError,
+//chi hien thong bao khi bShowErrors
+int LISFileClass::ReadReprCode(const BYTE byteArr[], int nCount, int nReprCode, ReprCodeReturn& ret, int& nRealSize, int nCurPos)
+{
+	int		nRet = LISMisc::ReadReprCode(byteArr, nCount, nReprCode, ret, nRealSize, nCurPos, this->bShowErrors);
+
+	if(nRet == 0)
+		this->bDecodeError = true;
+
+	return nRet;
+}
+
+//Bao loi giai ma mot lan tren thread goi ham, sau khi cac worker thread da xong
+void LISFileClass::ReportDecodeError(void)
+{
+	this->bDecodeError = true;
+	if(this->bShowErrors)
+		AfxMessageBox("Read Repr. Code");
+}
+
+//So byte du lieu cua Logical Rec nLRIdx (khong tinh header cua cac PR)
+int LISFileClass::GetLogRecDataSize(int nLRIdx)
 {
 	int		nTotalSize = 0;
-    int		nCurrentSize = 0;
-    int		nIdx1, nIdx2;
-	CPoint	pt;
-	CString	str;
+    int		nIdx1;
 
     nIdx1 = nLRIdx;
     
@@ -652,337 +832,393 @@ int LISFileClass::ReadLogRecBytes(int nLRIdx)
     bool bRecordNumPresence;
 
 	//Calculate TotalSize
-    nTotalSize = (int)this->lrArr[nIdx1].prArr[0].lLen - 6;
-    bFileNumPresence =  ((this->lrArr[nIdx1].prArr[0].attr1 & 0x4) > 0);
-    bRecordNumPresence = ((this->lrArr[nIdx1].prArr[0].attr1 & 0x2) > 0);
+    nTotalSize = (int)this->GetPRArr(nIdx1)[0].lLen - 6;
+    bFileNumPresence =  ((this->GetPRArr(nIdx1)[0].attr1 & 0x4) > 0);
+    bRecordNumPresence = ((this->GetPRArr(nIdx1)[0].attr1 & 0x2) > 0);
     if (bFileNumPresence) nTotalSize -= 2;
     if (bRecordNumPresence) nTotalSize -= 2;
 
-    for (int i = 1; i < this->lrArr[nIdx1].nPhysicalRecordNum; i++)
+    for (int i = 1; i < this->GetPRNum(nIdx1); i++)
     {
-        nTotalSize += (int)this->lrArr[nIdx1].prArr[i].lLen - 4;
+        nTotalSize += (int)this->GetPRArr(nIdx1)[i].lLen - 4;
 
-        bFileNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x4) > 0);
-        bRecordNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x2) > 0);
+        bFileNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x4) > 0);
+        bRecordNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x2) > 0);
         if (bFileNumPresence) nTotalSize -= 2;
         if (bRecordNumPresence) nTotalSize -= 2;
     }
+
+	return nTotalSize;
+}
+
+//Doc du lieu cua Logical Rec nLRIdx. Ket qua nam o pLogRecBytes:
+//tro thang vao vung anh xa neu LR chi gom 1 PR, nguoc lai tro vao pBytesBuf.
+int LISFileClass::ReadLogRecBytes(int nLRIdx)
+{
+	return this->ReadLogRecBytes(nLRIdx, this->pBytesBuf, this->pLogRecBytes);
+}
+
+//Nhu tren nhung dung bo dem pBuf cua nguoi goi (kich thuoc >= nLogRecMaxSize).
+//Khong thay doi trang thai cua doi tuong; an toan khi goi tu nhieu thread
+//neu file da duoc anh xa (mappedFile).
+int LISFileClass::ReadLogRecBytes(int nLRIdx, BYTE* pBuf, const BYTE*& pBytes)
+{
+	int		nTotalSize = this->GetLogRecDataSize(nLRIdx);
+    int		nCurrentSize = 0;
+    int		nIdx1;
+
+    nIdx1 = nLRIdx;
+    
+    bool bFileNumPresence;
+    bool bRecordNumPresence;
+
+	////////////////////////////////////////////////////
+	//Zero-copy: LR nam gon trong 1 PR
+	if(this->mappedFile.IsOpen() && this->GetPRNum(nIdx1) == 1 &&
+		this->mappedFile.Contains((long)this->GetPRArr(nIdx1)[0].lAddress + 6, nTotalSize))
+	{
+		pBytes = this->mappedFile.GetPtr((long)this->GetPRArr(nIdx1)[0].lAddress + 6);
+		this->perfStats.AddRead(nTotalSize, 0);
+		return nTotalSize;
+	}
 	////////////////////////////////////////////////////
 	//Read ByteArr
     nCurrentSize = 0;
-	fseek(hFile, this->lrArr[nIdx1].prArr[0].lAddress + 6, SEEK_SET);
-	fread(this->pBytesBuf + nCurrentSize, sizeof(BYTE), (int)this->lrArr[nIdx1].prArr[0].lLen - 6, hFile);
+	this->ReadFileBytes(this->GetPRArr(nIdx1)[0].lAddress + 6, 
+		pBuf + nCurrentSize, (int)this->GetPRArr(nIdx1)[0].lLen - 6);
     
-	//for Debug
-	int	nn = this->lrArr[nIdx1].prArr[0].lLen - 6;
-
-    nCurrentSize = nCurrentSize + (int)this->lrArr[nIdx1].prArr[0].lLen - 6;
+    nCurrentSize = nCurrentSize + (int)this->GetPRArr(nIdx1)[0].lLen - 6;
     
-    bFileNumPresence = ((this->lrArr[nIdx1].prArr[0].attr1 & 0x4) > 0);
-    bRecordNumPresence = ((this->lrArr[nIdx1].prArr[0].attr1 & 0x2) > 0);
+    bFileNumPresence = ((this->GetPRArr(nIdx1)[0].attr1 & 0x4) > 0);
+    bRecordNumPresence = ((this->GetPRArr(nIdx1)[0].attr1 & 0x2) > 0);
     if (bFileNumPresence) nCurrentSize -= 2;
     if (bRecordNumPresence) nCurrentSize -= 2;
 
-    for (int i = 1; i < this->lrArr[nIdx1].nPhysicalRecordNum; i++)
+    for (int i = 1; i < this->GetPRNum(nIdx1); i++)
     {
-		fseek(hFile, this->lrArr[nIdx1].prArr[i].lAddress + 4, SEEK_SET);
-		fread(this->pBytesBuf + nCurrentSize, sizeof(BYTE), (int)this->lrArr[nIdx1].prArr[i].lLen - 4, hFile);
+		this->ReadFileBytes(this->GetPRArr(nIdx1)[i].lAddress + 4, 
+			pBuf + nCurrentSize, (int)this->GetPRArr(nIdx1)[i].lLen - 4);
         
-        nCurrentSize = nCurrentSize + (int)this->lrArr[nIdx1].prArr[i].lLen - 4;
+        nCurrentSize = nCurrentSize + (int)this->GetPRArr(nIdx1)[i].lLen - 4;
 
-        bFileNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x4) > 0);
-        bRecordNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x2) > 0);
+        bFileNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x4) > 0);
+        bRecordNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x2) > 0);
         if (bFileNumPresence) nCurrentSize -= 2;
         if (bRecordNumPresence) nCurrentSize -= 2;
     }
 
+	pBytes = pBuf;
+
 	return nTotalSize;
 }
 
-void LISFileClass::Parse(void)
+//////////////////////////////////////////////////////////////////
+// Doc nCount byte tu byte nOffset cua du lieu Logical Rec nLRIdx (nhu
+// trong ReadLogRecBytes) ma khong doc ca Logical Rec: vi tri trong file
+// tinh tu bang PR, bo qua header va trailer cua tung PR.
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::ReadLogRecRange(int nLRIdx, int nOffset, BYTE* pDst, int nCount)
 {
-	this->ReleaseResources();
-
-	int				pos;
-	CString			str;
-
-	pos = this->strFileName.ReverseFind('\\');
-	this->strDirName = this->strFileName.Left(pos);
-	
-	hFile = fopen(this->strFileName, "rb");
-	
-	fseek(hFile, 0L, SEEK_END);
-	nFileSize = ftell(hFile);
-	fseek(hFile, 0L, SEEK_SET);
+	PhysicalRecord*	pPR = this->GetPRArr(nLRIdx);
+	int				nPRNum = this->GetPRNum(nLRIdx);
+	int				nPRStart = 0;//Vi tri du lieu cua PR i trong Logical Rec
 
-	/////////////////////////////////////////////////////
-	// File Type
-	long			lAddr=0;
-	long			lPrevAddr;
-	long			lNextAddr;
-	long			lRecLen;
-	int				nNum;
-	int				nBlankRecNum = 0;
-	
+	for(int i = 0; i < nPRNum && nCount > 0; i++)
+	{
+		int		nHeaderSize = (i == 0) ? 6 : 4;
+		int		nPRSize = (int)pPR[i].lLen - nHeaderSize;
 
-	BYTE			group1[16];
-	BYTE			group2[16];
-	BYTE			group3[16];
-	BYTE			group4[16];
+		if(pPR[i].attr1 & 0x4) nPRSize -= 2;
+		if(pPR[i].attr1 & 0x2) nPRSize -= 2;
 
-	fseek(hFile, 0L, SEEK_SET);
-	fread(group1, sizeof(BYTE), 4, hFile);
-	
-	if(LISMisc::Convert4Bytes2Long(group1) != 0)
-		nFileType = FILE_TYPE_NTI;
-	else
-		nFileType = FILE_TYPE_LIS;
+		if(nOffset < nPRStart + nPRSize)
+		{
+			int		nSkip = nOffset - nPRStart;
+			int		n = nPRSize - nSkip;
 
-	
-	/////////////////////////////////////////////////////
-	BYTE	byteArr[2000];
+			if(n > nCount)
+				n = nCount;
 
-	int		nContinuation;
-	int		lrl;
-	int		nType;
-	int		idx;
+			this->ReadFileBytes(pPR[i].lAddress + nHeaderSize + nSkip, pDst, n);
+			pDst += n;
+			nOffset += n;
+			nCount -= n;
+		}
+		nPRStart += nPRSize;
+	}
 
-	//Count the Logical Record Num
-	this->nLogicalRecordNum = 0;
-	fseek(hFile, 0L, SEEK_SET);
+	return (nCount == 0);
+}
 
-	lNextAddr = -1;
-	lPrevAddr = -1;
+//////////////////////////////////////////////////////////////////
+// Doc va giai ma nDataItemNum gia tri cua kenh nChan tai (Logical Rec
+// nLRIdx, frame nFrame, sample nSample) cua Logical File hien tai, chi
+// doc cac byte cua kenh do (ReadLogRecRange). Tra ve so gia tri ghi
+// vao pDst, 0 neu vi tri khong hop le.
+//////////////////////////////////////////////////////////////////
+int LISFileClass::ReadChannelSlice(int nChan, int nLRIdx, int nFrame, int nSample, float* pDst)
+{
+	if(nChan < 0 || nChan >= chansArr.GetCount() || this->nFrameSizeInBytes <= 0)
+		return 0;
+	if(nLRIdx < this->nFirstIFLR1 || nLRIdx > this->nEndIFLR1 || this->nFirstIFLR1 < 0)
+		return 0;
+
+	const DatumSpecBlock_t&	chan = chansArr[nChan];
+	int		nCodeSize = LISMisc::GetReprCodeSize(chan.nReprCode);
+	int		nCount = chan.nDataItemNum;
+	int		nDepthSize = 0;
+
+	if(nSample < 0 || nSample >= chan.nNbSamples || nCodeSize <= 0 || nCount <= 0)
+		return 0;
+
+	if(this->entryBlock.nDepthRecordingMode != 0)//Depth on log rec
+		nDepthSize = LISMisc::GetReprCodeSize(this->entryBlock.nDepthRepr);
+
+	int		nFrameNum = (this->GetLogRecDataSize(nLRIdx) - nDepthSize) / this->nFrameSizeInBytes;
+
+	if(nFrame < 0 || nFrame >= nFrameNum)
+		return 0;
+
+	//Vi tri cua kenh trong du lieu Logical Rec (nhu frame plan)
+	int		nOffset = nDepthSize + nFrame * this->nFrameSizeInBytes +
+						chan.nOffsetInBytes + nSample * nCount * nCodeSize;
+	int		nSize = nCount * nCodeSize;
+	BYTE	byteArr[1024];
+	BYTE*	pBytes = (nSize <= (int)sizeof(byteArr)) ? byteArr : new BYTE[nSize];
+	bool	bOK = this->ReadLogRecRange(nLRIdx, nOffset, pBytes, nSize);
+
+	if(bOK && LISReprCode::IsBatchSupported(chan.nReprCode))
+		LISReprCode::DecodeBatch(pBytes, chan.nReprCode, nCount, pDst);
+	else if(bOK)
+	{
+		ReprCodeReturn	ret;
+		int				nRealSize;
+		int				nCurPos = 0;
 
-    while (true)
-    {
-		if(nFileType == FILE_TYPE_LIS)
+		for(int item = 0; item < nCount; item++)
 		{
-			//Total 12 bytes: 
-			fseek(hFile, 4, SEEK_CUR);
-			fread(group2, sizeof(BYTE), 4, hFile);
-			fread(group3, sizeof(BYTE), 4, hFile);
-
-			lPrevAddr = LISMisc::Convert4Bytes2Long(group2);
-			lNextAddr = LISMisc::Convert4Bytes2Long(group3);
+			LISMisc::ReadReprCode(pBytes, nCodeSize, chan.nReprCode, ret, nRealSize, nCurPos);
+			pDst[item] = ret.fValue;
+			nCurPos += nRealSize;
 		}
-	
-		fread(byteArr, sizeof(BYTE), 6, hFile);
+	}
 
-		lrl = byteArr[0] * 256 + byteArr[1];
-		nContinuation = byteArr[3];
-        nContinuation = nContinuation & 0x3;
-        nType = byteArr[4];
+	if(pBytes != byteArr)
+		delete[] pBytes;
 
-		if(nContinuation == 1)//Logical Record span multiple Physical Record
-		{
-			fseek(hFile, lrl-6, SEEK_CUR);
-			while (nContinuation != 2)
-            {
-				if(nFileType == FILE_TYPE_LIS)
-				{
-					//Total 12 bytes: 
-					fseek(hFile, 4, SEEK_CUR);
-					fread(group2, sizeof(BYTE), 4, hFile);
-					fread(group3, sizeof(BYTE), 4, hFile);
+	return bOK ? nCount : 0;
+}
 
-					lPrevAddr = LISMisc::Convert4Bytes2Long(group2);
-					lNextAddr = LISMisc::Convert4Bytes2Long(group3);
-				}
+//Gia tri cua kenh nChan tai sample gan do sau fDepth (m) nhat (depthIndex)
+int LISFileClass::ReadChannelSlice(int nChan, double fDepth, float* pDst)
+{
+	int		nRec;
+	int		nFrame;
+	int		nSample;
+	int		nSampleDir = 1;
 
-				fread(byteArr, sizeof(BYTE), 4, hFile);
-		
-				lrl = byteArr[0] * 256 + byteArr[1];
-				nContinuation = byteArr[3];
-				nContinuation = nContinuation & 0x3;
+	if(nChan < 0 || nChan >= chansArr.GetCount())
+		return 0;
 
-				fseek(hFile, lrl-4, SEEK_CUR);
-			}
-		}
-		else
-		{
-			fseek(hFile, lrl-6, SEEK_CUR);
-		}
+	//Nhu DecodeLogRec: do sau trong frame thi sample theo huong do,
+	//do sau o dau record thi sample luon tang do sau
+	if(this->entryBlock.nDepthRecordingMode == 0 && this->entryBlock.nDirection == 1)
+		nSampleDir = -1;
 
-		
-		this->nLogicalRecordNum++;
+	if(!this->depthIndex.FindFrame(fDepth, chansArr[nChan].nNbSamples, nSampleDir, nRec, nFrame, nSample))
+		return 0;
 
-		if(nFileType == FILE_TYPE_NTI)
-			if(ftell(hFile)>= nFileSize-1) break;
+	return this->ReadChannelSlice(nChan, nRec, nFrame, nSample, pDst);
+}
+///////////////////////////////////////////////////////////
+// Quet toan bo file, tao lrIndex/prTable (nFileType da xac dinh)
+///////////////////////////////////////////////////////////
+void LISFileClass::ScanRecords(void)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_INDEX);
 
-		if(nFileType == FILE_TYPE_LIS)
-			if(ftell(hFile)>= nFileSize-12) break;
-	}
+	// Index all Logical Records / Physical Records in one sequential pass.
+	// Headers are served from large blocks (CLisBlockReader), the LR index is
+	// collected into growable columns (lrIndex) and the PR entries of all LRs
+	// are kept in one shared table (prTable).
+	BYTE	byteArr[16];
+
+	int		nContinuation;
+	int		lrl;
+
+	CLisBlockReader	reader;
+	if(this->mappedFile.IsOpen())
+		reader.AttachMapped(&this->mappedFile);
+	else
+		reader.Attach(hFile, nFileSize);
+	reader.pPerfStats = &this->perfStats;
 
-	this->lrArr = new LogicalRecord[this->nLogicalRecordNum];
+	int				nPRCapacity = 4096;
+	PhysicalRecord*	prList = new PhysicalRecord[nPRCapacity];
+	int				nPRNum = 0;
+	int				nLR;
+	long			lLRLen;
 
-	//str.Format("%d", this->nLogicalRecordNum);
-	//AfxMessageBox(str);
+	this->lrIndex.SetCapacity(4096);
+	this->nLogicalRecordNum = 0;
 
-	//Count the Physical Record Num in each Logical Record
 	if(this->progressBar != NULL)
 	{
-		this->progressBar->SetRange32(0, this->nLogicalRecordNum*2);
+		this->progressBar->SetRange32(0, 100);
 		this->progressBar->SetStep(1);
 		this->progressBar->SetPos(0);
 	}
 
-	fseek(hFile, 0L, SEEK_SET);
-	idx = 0;
+	reader.Seek(0);
 	while (true)
     {
 		if(nFileType == FILE_TYPE_LIS)
-		{
-			//Total 12 bytes: 
-			fseek(hFile, 4, SEEK_CUR);
-			fread(group2, sizeof(BYTE), 4, hFile);
-			fread(group3, sizeof(BYTE), 4, hFile);
+			reader.Skip(12);//Total 12 bytes: blank record
 
-			lPrevAddr = LISMisc::Convert4Bytes2Long(group2);
-			lNextAddr = LISMisc::Convert4Bytes2Long(group3);
-		}
+		nLR = this->nLogicalRecordNum;
+		if(nLR >= this->lrIndex.nCapacity)
+			this->lrIndex.SetCapacity(this->lrIndex.nCapacity * 2);
 
-		this->lrArr[idx].lAddress = ftell(hFile);
+		this->lrIndex.pAddress[nLR] = reader.Tell();
+		this->lrIndex.pPRStart[nLR] = nPRNum;
 
-		fread(byteArr, sizeof(BYTE), 6, hFile);
-		
-		lrl = byteArr[0] * 256 + byteArr[1];
-		this->lrArr[idx].lLen = lrl;
+		reader.Read(byteArr, 6);
 
+		lrl = byteArr[0] * 256 + byteArr[1];
 		nContinuation = byteArr[3];
         nContinuation = nContinuation & 0x3;
-        this->lrArr[idx].nType = byteArr[4];
 
-		this->lrArr[idx].nPhysicalRecordNum = 1;
+		lLRLen = lrl;
+		this->lrIndex.pType[nLR] = byteArr[4];
+
+		if(nPRNum >= nPRCapacity)
+			GrowIndexArray(prList, nPRNum, nPRCapacity);
+
+		prList[nPRNum].lAddress = this->lrIndex.pAddress[nLR];
+		prList[nPRNum].lLen = lrl;
+		prList[nPRNum].attr1 = byteArr[2];
+		prList[nPRNum].attr2 = byteArr[3];
+		nPRNum++;
 
 		if(nContinuation == 1)//Logical Record span multiple Physical Record
 		{
-			fseek(hFile, lrl-6, SEEK_CUR);
+			reader.Skip(lrl-6);
 			while (nContinuation != 2)
             {
 				if(nFileType == FILE_TYPE_LIS)
-				{
-					//Total 12 bytes: 
-					fseek(hFile, 4, SEEK_CUR);
-					fread(group2, sizeof(BYTE), 4, hFile);
-					fread(group3, sizeof(BYTE), 4, hFile);
+					reader.Skip(12);//Total 12 bytes: blank record
 
-					lPrevAddr = LISMisc::Convert4Bytes2Long(group2);
-					lNextAddr = LISMisc::Convert4Bytes2Long(group3);
-				}
+				if(reader.Tell() >= nFileSize) break;//Truncated file
+
+				if(nPRNum >= nPRCapacity)
+					GrowIndexArray(prList, nPRNum, nPRCapacity);
+
+				prList[nPRNum].lAddress = reader.Tell();
 
-				fread(byteArr, sizeof(BYTE), 4, hFile);
+				reader.Read(byteArr, 4);
 		
 				lrl = byteArr[0] * 256 + byteArr[1];
 				nContinuation = byteArr[3];
 				nContinuation = nContinuation & 0x3;
 
-				this->lrArr[idx].lLen += lrl;
-				this->lrArr[idx].nPhysicalRecordNum++;
+				prList[nPRNum].lLen = lrl;
+				prList[nPRNum].attr1 = byteArr[2];
+				prList[nPRNum].attr2 = byteArr[3];
+				nPRNum++;
 
-				fseek(hFile, lrl-4, SEEK_CUR);
+				lLRLen += lrl;
+
+				reader.Skip(lrl-4);
 			}
 		}
 		else
 		{
-			fseek(hFile, lrl-6, SEEK_CUR);
+			reader.Skip(lrl-6);
 		}
 
-		idx++;
+		this->lrIndex.pLen[nLR] = lLRLen;
+		this->nLogicalRecordNum++;
+		this->lrIndex.nCount = this->nLogicalRecordNum;
 
-		//if(ftell(hFile)>= nFileSize-1) break;
 		if(nFileType == FILE_TYPE_NTI)
-			if(ftell(hFile)>= nFileSize-1) break;
+			if(reader.Tell()>= nFileSize-1) break;
 
 		if(nFileType == FILE_TYPE_LIS)
-			if(ftell(hFile)>= nFileSize-12) break;
+			if(reader.Tell()>= nFileSize-12) break;
 
-		if(this->progressBar != NULL)
-			this->progressBar->StepIt();
+		if(this->progressBar != NULL && (this->nLogicalRecordNum & 0x3FF) == 0)
+			this->progressBar->SetPos((int)(100.0*reader.Tell()/nFileSize));
 	}
 
-	//Create Physical Record Array in each Logical Record;
-	for(int i = 0; i<this->nLogicalRecordNum; i++)
-		this->lrArr[i].prArr = new PhysicalRecord[this->lrArr[i].nPhysicalRecordNum];
+	reader.Detach();
 
-	fseek(hFile, 0L, SEEK_SET);
-	idx = 0;
-	while (true)
-    {
-		if(nFileType == FILE_TYPE_LIS)
-		{
-			//Total 12 bytes: 
-			fseek(hFile, 4, SEEK_CUR);
-			fread(group2, sizeof(BYTE), 4, hFile);
-			fread(group3, sizeof(BYTE), 4, hFile);
-
-			lPrevAddr = LISMisc::Convert4Bytes2Long(group2);
-			lNextAddr = LISMisc::Convert4Bytes2Long(group3);
-		}
-
-		this->lrArr[idx].lAddress = ftell(hFile);
+	this->lrIndex.pPRStart[this->nLogicalRecordNum] = nPRNum;
+	this->prTable = prList;
+	this->nPhysicalRecordNum = nPRNum;
+}
 
-		fread(byteArr, sizeof(BYTE), 6, hFile);
-		
-		lrl = byteArr[0] * 256 + byteArr[1];
-		nContinuation = byteArr[3];
-        nContinuation = nContinuation & 0x3;
-        
-		int idx1 = 0;
 
-		this->lrArr[idx].prArr[idx1].lAddress = this->lrArr[idx].lAddress;
-		this->lrArr[idx].prArr[idx1].lLen = lrl;
-		this->lrArr[idx].prArr[idx1].attr1 = byteArr[2];
-		this->lrArr[idx].prArr[idx1].attr2 = byteArr[3];
+///////////////////////////////////////////////////////////
+// Mo file strFileName (FILE*, anh xa neu bUseMappedFile) va xac dinh
+// nFileType
+///////////////////////////////////////////////////////////
+void LISFileClass::OpenFile(void)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_DETECT);
 
-		if(nContinuation == 1)//Logical Record span multiple Physical Record
-		{
-			fseek(hFile, lrl-6, SEEK_CUR);
-			while (nContinuation != 2)
-            {
-				if(nFileType == FILE_TYPE_LIS)
-				{
-					//Total 12 bytes: 
-					fseek(hFile, 4, SEEK_CUR);
-					fread(group2, sizeof(BYTE), 4, hFile);
-					fread(group3, sizeof(BYTE), 4, hFile);
+	int				pos;
 
-					lPrevAddr = LISMisc::Convert4Bytes2Long(group2);
-					lNextAddr = LISMisc::Convert4Bytes2Long(group3);
-				}
+	pos = this->strFileName.ReverseFind('\\');
+	this->strDirName = this->strFileName.Left(pos);
+	
+	hFile = fopen(this->strFileName, "rb");
 
-				idx1++;
-				this->lrArr[idx].prArr[idx1].lAddress = ftell(hFile);
+	if(this->bUseMappedFile)
+		this->mappedFile.Open(this->strFileName);
+	
+	_fseeki64(hFile, 0, SEEK_END);
+	nFileSize = _ftelli64(hFile);
+	_fseeki64(hFile, 0, SEEK_SET);
 
-				fread(byteArr, sizeof(BYTE), 4, hFile);
-		
-				lrl = byteArr[0] * 256 + byteArr[1];
-				nContinuation = byteArr[3];
-				nContinuation = nContinuation & 0x3;
+	/////////////////////////////////////////////////////
+	// File Type
+	BYTE			group1[16];
 
-				this->lrArr[idx].prArr[idx1].lLen = lrl;
-				this->lrArr[idx].prArr[idx1].attr1 = byteArr[2];
-				this->lrArr[idx].prArr[idx1].attr2 = byteArr[3];
+	//Nhan dang bang chuoi Blank Record o phan dau file (nhu CLisFile),
+	//neu khong ket luan duoc thi dung 4 byte dau
+	long	lPrefixLen = (nFileSize < LIS_DETECT_PREFIX) ? (long)nFileSize : LIS_DETECT_PREFIX;
+	BYTE*	pPrefix = new BYTE[lPrefixLen + 16];
 
-				fseek(hFile, lrl-4, SEEK_CUR);
-			}
-		}
-		else
-		{
-			fseek(hFile, lrl-6, SEEK_CUR);
-		}
+	memset(pPrefix, 0, 16);
+	this->ReadFileBytes(0, pPrefix, lPrefixLen);
+	memcpy(group1, pPrefix, 4);
 
-		idx++;
+	int		nFormat = LISFileType::Detect(pPrefix, lPrefixLen, nFileSize);
+	delete[] pPrefix;
 
-		if(nFileType == FILE_TYPE_NTI)
-			if(ftell(hFile)>= nFileSize-1) break;
+	if(nFormat == LIS_FORMAT_LIS)
+		nFileType = FILE_TYPE_LIS;
+	else if(nFormat == LIS_FORMAT_NTI)
+		nFileType = FILE_TYPE_NTI;
+	else if(LISMisc::Convert4Bytes2Long(group1) != 0)
+		nFileType = FILE_TYPE_NTI;
+	else
+		nFileType = FILE_TYPE_LIS;
+}
 
-		if(nFileType == FILE_TYPE_LIS)
-			if(ftell(hFile)>= nFileSize-12) break;
+void LISFileClass::Parse(void)
+{
+	this->ReleaseResources();
+	this->perfStats.Reset();
+	this->OpenFile();
+	
+	/////////////////////////////////////////////////////
+	// Bang LR/PR: lay tu file chi muc neu con khop voi file, neu khong quet file
+	bool	bIndexLoaded = (this->bUseIndexCache && this->LoadIndexCache());
 
-		if(this->progressBar != NULL)
-			this->progressBar->StepIt();
-	}
+	if(!bIndexLoaded)
+		this->ScanRecords();
+	
 	
 	if(this->progressBar != NULL)
 		this->progressBar->SetPos(0);
@@ -991,51 +1227,51 @@ void LISFileClass::Parse(void)
 	//
 	for (int i = 0; i < this->nLogicalRecordNum; i++)
     {
-        if (lrArr[i].nType == LRTYPE_JOBID)
+        if (lrIndex.pType[i] == LRTYPE_JOBID)
         {
             JobIDPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_WELLSITEDATA)
+        else if (lrIndex.pType[i] == LRTYPE_WELLSITEDATA)
         {
             WellsiteDataPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_TOOLSTRINGINFO)
+        else if (lrIndex.pType[i] == LRTYPE_TOOLSTRINGINFO)
         {
             ToolStringInfoPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_TABLEDUMP)
+        else if (lrIndex.pType[i] == LRTYPE_TABLEDUMP)
         {
             TableDumpPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_DATAFORMATSPEC)
+        else if (lrIndex.pType[i] == LRTYPE_DATAFORMATSPEC)
         {
             DataFormatSpecPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_FILEHEADER)
+        else if (lrIndex.pType[i] == LRTYPE_FILEHEADER)
         {
             FileHeaderPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_FILETRAILER)
+        else if (lrIndex.pType[i] == LRTYPE_FILETRAILER)
         {
             FileTrailerPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_TAPEHEADER)
+        else if (lrIndex.pType[i] == LRTYPE_TAPEHEADER)
         {
             TapeHeaderPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_TAPETRAILER)
+        else if (lrIndex.pType[i] == LRTYPE_TAPETRAILER)
         {
             TapeTrailerPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_REELHEADER)
+        else if (lrIndex.pType[i] == LRTYPE_REELHEADER)
         {
             ReelHeaderPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_REELTRAILER)
+        else if (lrIndex.pType[i] == LRTYPE_REELTRAILER)
         {
             ReelTrailerPos.Add(CPoint(i, 0));
         }
-        else if (lrArr[i].nType == LRTYPE_COMMENT)
+        else if (lrIndex.pType[i] == LRTYPE_COMMENT)
         {
             CommentPos.Add(CPoint(i, 0));
         }     
@@ -1044,70 +1280,158 @@ void LISFileClass::Parse(void)
 	//
 	//
 	CreateLogicalFileArr();
+	if(this->nLogicalFileNum == 0)
+		return;
 	
 	//Find the Default Logical file (the longest logical file)
 	this->nCurLogicalFile = 0;
-	int		lLen = this->lrArr[logicalFileArr[0].nEndIFLR1].lAddress - this->lrArr[logicalFileArr[0].nFirstIFLR1].lAddress;
+	__int64	lLen = this->lrIndex.pAddress[logicalFileArr[0].nEndIFLR1] - this->lrIndex.pAddress[logicalFileArr[0].nFirstIFLR1];
 	for(int i = 1; i<this->nLogicalFileNum; i++)
 	{
-		if((this->lrArr[logicalFileArr[i].nEndIFLR1].lAddress - 
-			this->lrArr[logicalFileArr[i].nFirstIFLR1].lAddress) > lLen)
+		if((this->lrIndex.pAddress[logicalFileArr[i].nEndIFLR1] - 
+			this->lrIndex.pAddress[logicalFileArr[i].nFirstIFLR1]) > lLen)
 		{
 			this->nCurLogicalFile = i;
-			lLen = this->lrArr[logicalFileArr[i].nEndIFLR1].lAddress - 
-					this->lrArr[logicalFileArr[i].nFirstIFLR1].lAddress;
+			lLen = this->lrIndex.pAddress[logicalFileArr[i].nEndIFLR1] - 
+					this->lrIndex.pAddress[logicalFileArr[i].nFirstIFLR1];
 		}
 	}
 
 	this->ParseLogicalFile(this->nCurLogicalFile);
+
+	if(this->bUseIndexCache && !bIndexLoaded)
+		this->SaveIndexCache();
 }
 
-void LISFileClass::CreateLogicalFileArr(void)
+///////////////////////////////////////////////////////////
+// File chi muc (.lidx): bang LR/PR va do sau cac IFLR cua Logical
+// File mac dinh, dung lai khi mo lai file chua thay doi
+///////////////////////////////////////////////////////////
+bool LISFileClass::LoadIndexCache(void)
 {
-	int nLogRecNum = this->nLogicalRecordNum;
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_INDEX);
+
+	CLisIndexCache	cache;
+	int				nInfoNum, nLRNum, nPRNum, nDepthNum;
+	int				nAddrNum, nTypeNum, nPRStartNum;
+
+	if(!cache.Load(this->strFileName, LIS_INDEXCACHE_LISFILECLASS))
+		return false;
+
+	const int*				pInfo = (const int*)cache.GetSection(LIS_IDXTAG_INFO, sizeof(int), nInfoNum);
+	const __int64*			pLen = (const __int64*)cache.GetSection(LIS_IDXTAG_LRLEN, sizeof(__int64), nLRNum);
+	const __int64*			pAddress = (const __int64*)cache.GetSection(LIS_IDXTAG_LRADDR, sizeof(__int64), nAddrNum);
+	const int*				pType = (const int*)cache.GetSection(LIS_IDXTAG_LRTYPE, sizeof(int), nTypeNum);
+	const int*				pPRStart = (const int*)cache.GetSection(LIS_IDXTAG_LRPRSTART, sizeof(int), nPRStartNum);
+	const PhysicalRecord*	pPR = (const PhysicalRecord*)cache.GetSection(LIS_IDXTAG_PR, sizeof(PhysicalRecord), nPRNum);
+	const LISDepthEntry*	pDepth = (const LISDepthEntry*)cache.GetSection(LIS_IDXTAG_DEPTH, sizeof(LISDepthEntry), nDepthNum);
+
+	if(pInfo == NULL || nInfoNum < 1 || pInfo[0] != this->nFileType)
+		return false;
+	if(pLen == NULL || pAddress == NULL || pType == NULL || pPRStart == NULL || pPR == NULL)
+		return false;
+	if(nLRNum <= 0 || nAddrNum != nLRNum || nTypeNum != nLRNum || nPRStartNum != nLRNum + 1)
+		return false;
+
+	//Moi LR co it nhat mot PR, PR cua LR cuoi ket thuc o cuoi bang PR
+	if(pPRStart[0] != 0 || pPRStart[nLRNum] != nPRNum)
+		return false;
+	for(int i = 0; i<nLRNum; i++)
+	{
+		if(pPRStart[i+1] <= pPRStart[i])
+			return false;
+	}
 
-    int nFirstIFLR1;
-    int nFirstIFLR2;
-    int nEndIFLR1;
-    int nEndIFLR2;
+	this->lrIndex.SetCapacity(nLRNum);
+	memcpy(this->lrIndex.pLen, pLen, nLRNum*sizeof(__int64));
+	memcpy(this->lrIndex.pAddress, pAddress, nLRNum*sizeof(__int64));
+	memcpy(this->lrIndex.pType, pType, nLRNum*sizeof(int));
+	memcpy(this->lrIndex.pPRStart, pPRStart, (nLRNum + 1)*sizeof(int));
+	this->lrIndex.nCount = nLRNum;
+	this->nLogicalRecordNum = nLRNum;
 
-    int nCurLR = 0;
+	this->prTable = new PhysicalRecord[nPRNum];
+	memcpy(this->prTable, pPR, nPRNum*sizeof(PhysicalRecord));
+	this->nPhysicalRecordNum = nPRNum;
 
-	this->nLogicalFileNum = 0;
+	this->cachedDepthArr.SetSize(nDepthNum);
+	if(nDepthNum > 0)
+		memcpy(this->cachedDepthArr.GetData(), pDepth, nDepthNum*sizeof(LISDepthEntry));
 
-    while (true)
+	return true;
+}
+
+bool LISFileClass::SaveIndexCache(void)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_INDEX);
+
+	if(this->lrIndex.pBlock == NULL || this->nLogicalRecordNum <= 0)
+		return false;
+
+	CLisIndexCache	cache;
+	int				nInfo[1];
+	int				nLRNum = this->nLogicalRecordNum;
+
+	nInfo[0] = this->nFileType;
+
+	//Cac cot chi muc ghi thang ra file, khong can chuyen doi
+	cache.AddSection(LIS_IDXTAG_INFO, nInfo, sizeof(int), 1);
+	cache.AddSection(LIS_IDXTAG_LRLEN, this->lrIndex.pLen, sizeof(__int64), nLRNum);
+	cache.AddSection(LIS_IDXTAG_LRADDR, this->lrIndex.pAddress, sizeof(__int64), nLRNum);
+	cache.AddSection(LIS_IDXTAG_LRTYPE, this->lrIndex.pType, sizeof(int), nLRNum);
+	cache.AddSection(LIS_IDXTAG_LRPRSTART, this->lrIndex.pPRStart, sizeof(int), nLRNum + 1);
+	cache.AddSection(LIS_IDXTAG_PR, this->prTable, sizeof(PhysicalRecord), this->nPhysicalRecordNum);
+	cache.AddSection(LIS_IDXTAG_DEPTH, this->depthIndex.entryArr.GetData(), sizeof(LISDepthEntry), this->depthIndex.GetCount());
+
+	return cache.Save(this->strFileName, LIS_INDEXCACHE_LISFILECLASS);
+}
+
+void LISFileClass::CreateLogicalFileArr(void)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_INDEX);
+
+	int nLogRecNum = this->nLogicalRecordNum;
+
+    int nCurLR = 0;
+
+	LogicalFile		lf;
+
+	this->logicalFileArr.RemoveAll();
+	this->eflrIdxArr.RemoveAll();
+	this->nLogicalFileNum = 0;
+
+    while (true)
     {
         //Skip 
-        while ((nCurLR < nLogRecNum) && (lrArr[nCurLR].nType != LRTYPE_NORMALDATA))
+        while ((nCurLR < nLogRecNum) && (lrIndex.pType[nCurLR] != LRTYPE_NORMALDATA))
             nCurLR++;
         if (nCurLR >= nLogRecNum) break;
 
-        nFirstIFLR1 = nCurLR;
-        nEndIFLR1 = nCurLR;
+		lf.Init();
+        lf.nFirstIFLR1 = nCurLR;
+        lf.nEndIFLR1 = nCurLR;
 
-        while ((nCurLR < nLogRecNum) && (lrArr[nCurLR].nType == LRTYPE_NORMALDATA))
+        while ((nCurLR < nLogRecNum) && (lrIndex.pType[nCurLR] == LRTYPE_NORMALDATA))
         {
-            nEndIFLR1 = nCurLR;
+            lf.nEndIFLR1 = nCurLR;
             nCurLR++;
         }
 
-		this->logicalFileArr[this->nLogicalFileNum].nFirstIFLR1 = nFirstIFLR1;
-		this->logicalFileArr[this->nLogicalFileNum].nEndIFLR1 = nEndIFLR1;
-
-		this->nLogicalFileNum++;
-
-		if(this->nLogicalFileNum >= MAX_LOGICALFILENUM) break;
+		this->logicalFileArr.Add(lf);
 
         if (nCurLR >= nLogRecNum) break;
     }
 
+	this->nLogicalFileNum = (int)this->logicalFileArr.GetCount();
+
     int nStartIdx;
     int nEndIdx;
-    //CPoint pt;
     int idx;
 
     for (idx = 0; idx < this->nLogicalFileNum; idx++)
     {
+		LogicalFile&	curLF = logicalFileArr[idx];
+
         if (idx == 0)
             nStartIdx = 0;
         else
@@ -1118,61 +1442,39 @@ void LISFileClass::CreateLogicalFileArr(void)
         else
             nEndIdx = logicalFileArr[idx + 1].nFirstIFLR1 - 1;
 
-        for (int i = nStartIdx; i < logicalFileArr[idx].nFirstIFLR1; i++)
+		curLF.nFirstEFLR = (int)this->eflrIdxArr.GetCount();
+
+		//EFLR dung truoc IFLR dau tien
+        for (int i = nStartIdx; i < curLF.nFirstIFLR1; i++)
         {
-            if (lrArr[i].nType == LRTYPE_JOBID)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].JobIDPos.Add(CPoint(i, 0));
-            }
-            else if (lrArr[i].nType == LRTYPE_WELLSITEDATA)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].WellsiteDataPos.Add(CPoint(i, 0));
-            }
-            else if (lrArr[i].nType == LRTYPE_TOOLSTRINGINFO)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].ToolStringInfoPos.Add(CPoint(i, 0));
-            }
-            else if (lrArr[i].nType == LRTYPE_TABLEDUMP)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].TableDumpPos.Add(CPoint(i, 0));
-            }
-            else if (lrArr[i].nType == LRTYPE_DATAFORMATSPEC)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].DataFormatSpecPos.Add(CPoint(i, 0));
-            }
-            else if (lrArr[i].nType == LRTYPE_FILEHEADER)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].FileHeaderPos.Add(CPoint(i, 0));
-            }
-            else if (lrArr[i].nType == LRTYPE_COMMENT)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].CommentPos.Add(CPoint(i, 0));
-            }
+			switch(lrIndex.pType[i])
+			{
+			case LRTYPE_JOBID:
+			case LRTYPE_WELLSITEDATA:
+			case LRTYPE_TOOLSTRINGINFO:
+			case LRTYPE_TABLEDUMP:
+			case LRTYPE_DATAFORMATSPEC:
+			case LRTYPE_FILEHEADER:
+			case LRTYPE_COMMENT:
+				this->eflrIdxArr.Add(i);
+				break;
+			}
         }
 
-
-        for (int i = logicalFileArr[idx].nEndIFLR1; i < nEndIdx; i++)
+		//File Trailer sau IFLR cuoi cung
+        for (int i = curLF.nEndIFLR1; i < nEndIdx; i++)
         {
-            if (lrArr[i].nType == LRTYPE_FILETRAILER)
-            {
-                //pt = new Point(i, 0);
-                logicalFileArr[idx].FileTrailerPos.Add(CPoint(i, 0));
-            }
+            if (lrIndex.pType[i] == LRTYPE_FILETRAILER)
+				this->eflrIdxArr.Add(i);
         }
+
+		curLF.nEFLRNum = (int)this->eflrIdxArr.GetCount() - curLF.nFirstEFLR;
     }
 }
 
-
 void LISFileClass::ParseLogicalFile(int nCurLF)
 {
-	 if (lrArr == NULL)
+	 if (lrIndex.pBlock == NULL)
         return;
 
     //int nLogicalFileNum = logicalFileArr.Count;
@@ -1180,34 +1482,33 @@ void LISFileClass::ParseLogicalFile(int nCurLF)
     if (nCurLF < 0 || nCurLF >= this->nLogicalFileNum) return;
     /////////////////////////////////////////////////////////
     this->ReleaseEFLRArr(false);
+	this->bDecodeError = false;
 
-    for (int i = 0; i < logicalFileArr[nCurLF].JobIDPos.GetCount(); i++)
-        this->JobIDPos.Add(logicalFileArr[nCurLF].JobIDPos[i]);
+    //Doi tuong con (AttachIndex) dung chung chi muc cua doi tuong goc
+    LISFileClass*	pIndex = (this->pIndexSource != NULL ? this->pIndexSource : this);
+    LogicalFile&	lf = pIndex->logicalFileArr[nCurLF];
+	const int*		pEFLRIdx = pIndex->eflrIdxArr.GetData() + lf.nFirstEFLR;
 
-    for (int i = 0; i < logicalFileArr[nCurLF].WellsiteDataPos.GetCount(); i++)
-        this->WellsiteDataPos.Add(logicalFileArr[nCurLF].WellsiteDataPos[i]);
-
-    for (int i = 0; i < logicalFileArr[nCurLF].ToolStringInfoPos.GetCount(); i++)
-        this->ToolStringInfoPos.Add(logicalFileArr[nCurLF].ToolStringInfoPos[i]);
-
-    for (int i = 0; i < logicalFileArr[nCurLF].TableDumpPos.GetCount(); i++)
-        this->TableDumpPos.Add(logicalFileArr[nCurLF].TableDumpPos[i]);
-
-    for (int i = 0; i < logicalFileArr[nCurLF].DataFormatSpecPos.GetCount(); i++)
-        this->DataFormatSpecPos.Add(logicalFileArr[nCurLF].DataFormatSpecPos[i]);
-
-    for (int i = 0; i < logicalFileArr[nCurLF].FileHeaderPos.GetCount(); i++)
-        this->FileHeaderPos.Add(logicalFileArr[nCurLF].FileHeaderPos[i]);
-
-    for (int i = 0; i < logicalFileArr[nCurLF].FileTrailerPos.GetCount(); i++)
-        this->FileTrailerPos.Add(logicalFileArr[nCurLF].FileTrailerPos[i]);
+    for (int i = 0; i < lf.nEFLRNum; i++)
+    {
+		CPoint	pt(pEFLRIdx[i], 0);
 
-    for (int i = 0; i < logicalFileArr[nCurLF].CommentPos.GetCount(); i++)
-        this->CommentPos.Add(logicalFileArr[nCurLF].CommentPos[i]);
+		switch(lrIndex.pType[pt.x])
+		{
+		case LRTYPE_JOBID:			this->JobIDPos.Add(pt);				break;
+		case LRTYPE_WELLSITEDATA:	this->WellsiteDataPos.Add(pt);		break;
+		case LRTYPE_TOOLSTRINGINFO:	this->ToolStringInfoPos.Add(pt);	break;
+		case LRTYPE_TABLEDUMP:		this->TableDumpPos.Add(pt);			break;
+		case LRTYPE_DATAFORMATSPEC:	this->DataFormatSpecPos.Add(pt);	break;
+		case LRTYPE_FILEHEADER:		this->FileHeaderPos.Add(pt);		break;
+		case LRTYPE_FILETRAILER:	this->FileTrailerPos.Add(pt);		break;
+		case LRTYPE_COMMENT:		this->CommentPos.Add(pt);			break;
+		}
+    }
 
     ///////////////////////////////////////////////////////////////////
-    this->nFirstIFLR1 = logicalFileArr[nCurLF].nFirstIFLR1;
-    this->nEndIFLR1 = logicalFileArr[nCurLF].nEndIFLR1;
+    this->nFirstIFLR1 = lf.nFirstIFLR1;
+    this->nEndIFLR1 = lf.nEndIFLR1;
     
     /*this.ParseReelTape(this.ReelHeaderPos, ref this.reelHeader);
     this.ParseReelTape(this.ReelTrailerPos, ref this.reelTrailer);
@@ -1222,8 +1523,27 @@ void LISFileClass::ParseLogicalFile(int nCurLF)
     this.CreateWellsiteDataSet();*/
 
     this->ParseDataFormatSpecRecord();
+    this->SetupFrameFormat();
+
+    this->nLogRecMaxSize = (int)this->lrIndex.pLen[nFirstIFLR1];
+    for (int i = nFirstIFLR1; i <= nEndIFLR1; i++)
+        if (this->lrIndex.pLen[i] > this->nLogRecMaxSize)
+            this->nLogRecMaxSize = (int)this->lrIndex.pLen[i];
+	if(this->pBytesBuf != NULL)
+		delete[] this->pBytesBuf;
+	this->pBytesBuf = new BYTE[this->nLogRecMaxSize];
+
+    fStartDepth = this->GetStartDepth();
+    fEndDepth = this->GetEndDepth(fStep);
+	//////////////////////////////////////////////////////////////////
+	
+    CreateDataSet();
+	CreateDepthIndex();
+}
 
-    ////////////////////////////////////////////////////
+//Kenh do sau, kich thuoc frame va buoc do sau tu DFSR vua doc (chansArr, entryBlock)
+void LISFileClass::SetupFrameFormat(void)
+{
     this->nDepthCurveIdx = -1;
     if (this->entryBlock.nDepthRecordingMode == 0)//Depth in each frame
     {
@@ -1240,29 +1560,492 @@ void LISFileClass::ParseLogicalFile(int nCurLF)
 		if(this->nDepthCurveIdx == -1) this->nDepthCurveIdx = 0;
     }
 
-    this->nLogRecMaxSize = this->lrArr[nFirstIFLR1].lLen;
-    for (int i = nFirstIFLR1; i <= nEndIFLR1; i++)
-        if (this->lrArr[i].lLen > this->nLogRecMaxSize)
-            this->nLogRecMaxSize = this->lrArr[i].lLen;
-	if(this->pBytesBuf != NULL)
-		delete[] this->pBytesBuf;
-	this->pBytesBuf = new BYTE[this->nLogRecMaxSize];
-
     this->nFrameSizeInBytes = 0;//in bytes
 
     for (int i = 0; i < chansArr.GetCount(); i++)
         nFrameSizeInBytes += chansArr[i].nSize;
 
 	fStep = LISMisc::ConvertDepthValue(this->entryBlock.fFrameSpacing, this->entryBlock.strFrameSpacingUnit, "m");
-    fStartDepth = this->GetStartDepth();
-    fEndDepth = this->GetEndDepth(fStep);
-	//////////////////////////////////////////////////////////////////
-	
-    CreateDataSet();
+
+	//Don vi do sau: phan tich mot lan cho ca Logical File
+	this->depthUnit = DepthUnit_t();
+	if (this->entryBlock.nDepthRecordingMode == 0 && this->nDepthCurveIdx < this->chansArr.GetCount())
+		this->depthUnit = LISMisc::GetDepthUnit(chansArr[this->nDepthCurveIdx].strUnits, "m");
+	else if (this->entryBlock.nDepthRecordingMode != 0)
+		this->depthUnit = LISMisc::GetDepthUnit(this->entryBlock.strDepthUnit, "m");
+}
+
+//////////////////////////////////////////////////////////////////
+// Dung chung chi muc (lrIndex, prTable, logicalFileArr) cua pSrc da Parse().
+// Doi tuong nay mo file rieng (FILE*/mapping rieng), con chi muc chi doc,
+// nen nhieu doi tuong co the chuyen doi cac Logical File song song.
+//////////////////////////////////////////////////////////////////
+void LISFileClass::AttachIndex(LISFileClass* pSrc)
+{
+	this->ReleaseResources();
+
+	this->strFileName = pSrc->strFileName;
+	this->strDirName = pSrc->strDirName;
+	this->nFileType = pSrc->nFileType;
+	this->nFileSize = pSrc->nFileSize;
+
+	this->lrIndex = pSrc->lrIndex;
+	this->nLogicalRecordNum = pSrc->nLogicalRecordNum;
+	this->prTable = pSrc->prTable;
+	this->nPhysicalRecordNum = pSrc->nPhysicalRecordNum;
+	this->nLogicalFileNum = pSrc->nLogicalFileNum;
+	this->pIndexSource = pSrc;
+
+	this->bUseMappedFile = pSrc->bUseMappedFile;
+	this->bColumnOutput = pSrc->bColumnOutput;
+	this->bSelectiveLoad = pSrc->bSelectiveLoad;
+	if(pSrc->bSelectiveLoad)
+		pSrc->GetChannelSelection(this->selectChanArr);
+	this->perfStats.bEnabled = pSrc->perfStats.bEnabled;
+	this->progressBar = NULL;
+
+	this->hFile = fopen(this->strFileName, "rb");
+	if(this->bUseMappedFile)
+		this->mappedFile.Open(this->strFileName);
+}
+
+class LISConvertParam
+{
+public:
+	LISFileClass*	pSrc;
+	int*			pResultArr;
+	bool*			pDecodeErrorArr;//bDecodeError cua tung Logical File: bao loi sau khi xong
+	LISPerfStats*	pStatsArr;//Bo dem cua tung Logical File, cong lai sau khi xong
+};
+
+static void LISConvertLogicalFileProc(int nIdx, void* pParam)
+{
+	LISConvertParam*	pConvert = (LISConvertParam*)pParam;
+	LISFileClass		lisFile;
+
+	lisFile.AttachIndex(pConvert->pSrc);
+	if(lisFile.hFile == NULL)
+		return;
+
+	//Cac Logical File da chay song song: moi file giai ma tuan tu,
+	//khong hien thong bao tren worker thread
+	lisFile.nDecodeThreadNum = 1;
+	lisFile.bShowErrors = false;
+
+	lisFile.strDATPrefix.Format("LF%d_", nIdx);
+	lisFile.ParseLogicalFile(nIdx);
+	if(lisFile.DATASETArr.GetCount() == 0)
+	{
+		pConvert->pDecodeErrorArr[nIdx] = lisFile.bDecodeError;
+		return;
+	}
+
+	if(lisFile.CreateDATFiles())
+		pConvert->pResultArr[nIdx] = 1;
+	pConvert->pDecodeErrorArr[nIdx] = lisFile.bDecodeError;
+	pConvert->pStatsArr[nIdx] = lisFile.perfStats;
+}
+
+//////////////////////////////////////////////////////////////////
+// Chuyen doi tat ca Logical File sang DAT tren nhieu thread.
+// Moi Logical File co doi tuong, bo dem, chansArr va file DAT rieng
+// (LF<i>_Dataset_<j>.dat). Goi sau Parse(). Tra ve so Logical File
+// da chuyen doi.
+//////////////////////////////////////////////////////////////////
+int LISFileClass::ConvertAllLogicalFiles(int nThreadNum)
+{
+	if(this->lrIndex.pBlock == NULL || this->nLogicalFileNum <= 0)
+		return 0;
+
+	LISConvertParam		param;
+	int					nConverted = 0;
+
+	param.pSrc = this;
+	param.pResultArr = new int[this->nLogicalFileNum];
+	memset(param.pResultArr, 0, this->nLogicalFileNum * sizeof(int));
+	param.pDecodeErrorArr = new bool[this->nLogicalFileNum];
+	memset(param.pDecodeErrorArr, 0, this->nLogicalFileNum * sizeof(bool));
+	param.pStatsArr = new LISPerfStats[this->nLogicalFileNum];
+
+	//Cac Logical File chay dong thoi: thoi gian do chung la LIS_PHASE_DECODE
+	CLisPerfScope	decodeScope(this->perfStats, LIS_PHASE_DECODE);
+	LISParallel::For(this->nLogicalFileNum, LISConvertLogicalFileProc, &param,
+					nThreadNum, this->progressBar);
+	decodeScope.Stop();
+
+	bool	bDecodeError = false;
+
+	for(int i = 0; i < this->nLogicalFileNum; i++)
+	{
+		nConverted += param.pResultArr[i];
+		if(param.pDecodeErrorArr[i])
+			bDecodeError = true;
+		this->perfStats.AddCounters(param.pStatsArr[i]);
+	}
+	delete[] param.pResultArr;
+	delete[] param.pDecodeErrorArr;
+	delete[] param.pStatsArr;
+
+	this->bDecodeError = false;
+	if(bDecodeError)
+		this->ReportDecodeError();
+
+	return nConverted;
+}
+
+//Logical File dang duoc ghi trong ConvertStreaming
+class LISStreamRun
+{
+public:
+	LISFileClass*		pLis;
+	FrameDecodeCtx_t	ctx;
+	int*				pSampleOp;
+	CLisDatWriter*		pWriterArr;
+	float**				pRowArr;
+	int					nDatasetNum;
+	int					nWindowSize;
+	bool				bReverse;//Huong UP: dao nguoc cac dong khi ket thuc
+	bool				bError;//Khong tao/ghi duoc file DAT, hoac khong kenh nao duoc chon
+	bool				bDecodeError;//Gap ma khong giai ma duoc (bao loi khi ConvertStreaming xong)
+public:
+	LISStreamRun(LISFileClass* pLis, int nWindowSize)
+	{
+		this->pLis = pLis;
+		this->pSampleOp = NULL;
+		this->pWriterArr = NULL;
+		this->pRowArr = NULL;
+		this->nDatasetNum = 0;
+		this->nWindowSize = nWindowSize;
+		this->bReverse = false;
+		this->bError = false;
+		this->bDecodeError = false;
+	}
+
+	bool	IsActive() const	{ return this->pWriterArr != NULL; }
+	bool	Start(int nLF);
+	void	Append(const BYTE* pBytes, int nLogRecSize);
+	bool	Finish();
+};
+
+//Tao Dataset va file DAT cua Logical File nLF tu DFSR da doc
+bool LISStreamRun::Start(int nLF)
+{
+	pLis->SetupFrameFormat();
+	if(pLis->nFrameSizeInBytes <= 0)
+		return false;
+
+	pLis->strDATPrefix.Format("LF%d_", nLF);
+	pLis->CreateDataSet();
+
+	this->nDatasetNum = (int)pLis->DATASETArr.GetCount();
+	if(this->nDatasetNum == 0)
+	{
+		//bSelectiveLoad: khong kenh nao cua Logical File duoc chon
+		if(pLis->bSelectiveLoad)
+			this->bError = true;
+		return false;
+	}
+
+	Dataset_t*	pDatasets = pLis->DATASETArr.GetData();
+
+	for(int i = 0; i<this->nDatasetNum; i++)
+	{
+		pDatasets[i].hFile = fopen(pDatasets[i].strDATFileName, "wb");
+		if(pDatasets[i].hFile == NULL)
+		{
+			for(int j = 0; j<i; j++)
+			{
+				fclose(pDatasets[j].hFile);
+				pDatasets[j].hFile = NULL;
+			}
+			this->bError = true;
+			return false;
+		}
+	}
+
+	//Ghi theo thu tu trong file; huong UP dao nguoc cac dong trong Finish
+	pLis->InitDecodeCtx(this->ctx, this->pSampleOp);
+	this->bReverse = this->ctx.bReverse;
+	this->ctx.bReverse = false;
+
+	this->pWriterArr = new CLisDatWriter[this->nDatasetNum];
+	this->pRowArr = new float*[this->nDatasetNum];
+
+	for(int i = 0; i<this->nDatasetNum; i++)
+		this->pWriterArr[i].Attach(pDatasets[i].hFile, pDatasets[i].nTotalItemNum + 1,
+								this->nWindowSize / this->nDatasetNum);
+
+	return true;
+}
+
+void LISStreamRun::Append(const BYTE* pBytes, int nLogRecSize)
+{
+	int			nFrameNum = pLis->GetFrameNum(this->ctx, nLogRecSize);
+	Dataset_t*	pDatasets = pLis->DATASETArr.GetData();
+
+	CLisPerfScope	writeScope(pLis->perfStats, LIS_PHASE_WRITE);
+	for(int dataset = 0; dataset < this->nDatasetNum; dataset++)
+		this->pRowArr[dataset] = this->pWriterArr[dataset].AppendRows(nFrameNum * pDatasets[dataset].nNbSamples);
+	writeScope.Stop();
+
+	CLisPerfScope	decodeScope(pLis->perfStats, LIS_PHASE_DECODE);
+	if(!pLis->DecodeLogRec(this->ctx, pBytes, nFrameNum, this->pRowArr))
+		this->bDecodeError = true;
+	decodeScope.Stop();
+
+	pLis->perfStats.AddDecoded(1, nFrameNum, (LONGLONG)nFrameNum*this->ctx.nFrameValueNum);
+}
+
+//Ghi not bo dem, dong file DAT va dao nguoc cac dong (huong UP)
+bool LISStreamRun::Finish()
+{
+	if(!IsActive())
+		return false;
+
+	Dataset_t*	pDatasets = pLis->DATASETArr.GetData();
+	bool		bOK = true;
+	CLisPerfScope	writeScope(pLis->perfStats, LIS_PHASE_WRITE);
+
+	//Ghi phan con lai trong bo dem
+	for(int i = 0; i<this->nDatasetNum; i++)
+		if(!this->pWriterArr[i].Flush())
+			bOK = false;
+
+	delete[] this->pWriterArr;
+	delete[] this->pRowArr;
+	delete[] this->pSampleOp;
+	this->pWriterArr = NULL;
+	this->pRowArr = NULL;
+	this->pSampleOp = NULL;
+
+	for(int i = 0; i<this->nDatasetNum; i++)
+	{
+		if(fclose(pDatasets[i].hFile) != 0)
+			bOK = false;
+		pDatasets[i].hFile = NULL;
+	}
+	writeScope.Stop();
+
+	if(bOK && this->bReverse)
+	{
+		CLisPerfScope	reverseScope(pLis->perfStats, LIS_PHASE_REVERSE);
+
+		for(int i = 0; bOK && i<this->nDatasetNum; i++)
+			bOK = CLisDatWriter::ReverseRows(pDatasets[i].strDATFileName, pDatasets[i].nTotalItemNum + 1,
+									this->nWindowSize);
+	}
+
+	//So dong chi biet sau khi doc het Logical File: chuyen sang file cot o buoc cuoi
+	if(bOK && pLis->bColumnOutput)
+		bOK = pLis->ConvertDATToColumnFile(this->nWindowSize);
+
+	if(!bOK)
+		this->bError = true;
+
+	return bOK;
+}
+
+//////////////////////////////////////////////////////////////////
+// Chuyen doi tat ca Logical File sang DAT trong mot lan doc file tu dau
+// den cuoi, khong tao chi muc (lrIndex/prTable): chi doc tuan tu, vi tri
+// 64-bit nen dung duoc cho file > 2 GB. DFSR va du lieu IFLR duoc doc vao
+// bo dem, DFSR giai ma tu bo dem, IFLR giai ma va ghi ngay. Bo nho gioi
+// han boi nWindowSize (bo dem ghi, dao dong) va Logical Rec lon nhat.
+// Moi Logical File (chuoi IFLR lien tiep) dung DFSR dau tien dung truoc
+// no va ghi ra LF<i>_Dataset_<j>.dat nhu ConvertAllLogicalFiles.
+// bSelectiveLoad: chi ghi cac kenh duoc chon (selectChanArr/bLoad).
+// Tra ve so Logical File da chuyen doi, -1 neu khong tao/ghi duoc file DAT
+// hoac khong kenh nao cua mot Logical File duoc chon.
+//////////////////////////////////////////////////////////////////
+int LISFileClass::ConvertStreaming(int nWindowSize)
+{
+	//Chon bang bLoad: giu lai thanh danh sach, bLoad bi dat lai khi doc DFSR
+	if(this->bSelectiveLoad && this->selectChanArr.GetCount() == 0)
+	{
+		CArray<CString>	mnemonicArr;
+
+		this->GetChannelSelection(mnemonicArr);
+		this->SelectChannels(mnemonicArr);
+	}
+
+	this->ReleaseResources();
+	this->perfStats.Reset();
+	this->bDecodeError = false;
+	this->OpenFile();
+	if(this->hFile == NULL)
+		return 0;
+
+	CLisBlockReader	reader;
+	if(this->mappedFile.IsOpen())
+		reader.AttachMapped(&this->mappedFile);
+	else
+		reader.Attach(hFile, nFileSize);
+	reader.pPerfStats = &this->perfStats;
+
+	BYTE			byteArr[16];
+	int				nContinuation;
+	int				lrl;
+
+	//Du 100 byte sau du lieu cho ParseDataFormatSpecBytes
+	int				nBufSize = 64*1024;
+	BYTE*			pBuf = new BYTE[nBufSize + 100];
+	int				nDataSize;
+
+	LISStreamRun	run(this, nWindowSize);
+	bool			bInRun = false;//Dang o trong chuoi IFLR
+	bool			bHaveDFSR = false;
+	bool			bError = false;
+	int				nLF = 0;
+	int				nConverted = 0;
+	int				nLRNum = 0;
+
+	if(this->progressBar != NULL)
+	{
+		this->progressBar->SetRange32(0, 100);
+		this->progressBar->SetStep(1);
+		this->progressBar->SetPos(0);
+	}
+
+	reader.Seek(0);
+	while (true)
+	{
+		if(nFileType == FILE_TYPE_LIS)
+			reader.Skip(12);//Total 12 bytes: blank record
+
+		CLisPerfScope	headerScope(this->perfStats, LIS_PHASE_READ);
+		reader.Read(byteArr, 6);
+
+		lrl = byteArr[0] * 256 + byteArr[1];
+		nContinuation = byteArr[3];
+		nContinuation = nContinuation & 0x3;
+
+		int		nType = byteArr[4];
+		headerScope.Stop();
+
+		//Het chuoi IFLR: ket thuc Logical File
+		if(bInRun && nType != LRTYPE_NORMALDATA)
+		{
+			if(run.Finish())
+				nConverted++;
+			if(run.bError)
+			{
+				bError = true;
+				break;
+			}
+			bInRun = false;
+			bHaveDFSR = false;
+			nLF++;
+		}
+		if(!bInRun && nType == LRTYPE_NORMALDATA)
+		{
+			bInRun = true;
+			if(bHaveDFSR && !run.Start(nLF) && run.bError)
+			{
+				bError = true;
+				break;
+			}
+		}
+
+		//Chi doc du lieu cua IFLR can ghi va cua DFSR, cac LR khac bo qua
+		CLisPerfScope	readScope(this->perfStats, LIS_PHASE_READ);
+		bool	bDFSR = (nType == LRTYPE_DATAFORMATSPEC && !bHaveDFSR);
+		bool	bKeep = (nType == LRTYPE_NORMALDATA && run.IsActive()) || bDFSR;
+
+		nDataSize = 0;
+
+		if(bKeep && lrl > 6)
+		{
+			reader.Read(pBuf, lrl - 6);
+			nDataSize = lrl - 6;
+			if(byteArr[2] & 0x4) nDataSize -= 2;
+			if(byteArr[2] & 0x2) nDataSize -= 2;
+		}
+		else
+			reader.Skip(lrl-6);
+
+		if(nContinuation == 1)//Logical Record span multiple Physical Record
+		{
+			while (nContinuation != 2)
+			{
+				if(nFileType == FILE_TYPE_LIS)
+					reader.Skip(12);//Total 12 bytes: blank record
+
+				if(reader.Tell() >= nFileSize) break;//Truncated file
+
+				reader.Read(byteArr, 4);
+
+				lrl = byteArr[0] * 256 + byteArr[1];
+				nContinuation = byteArr[3];
+				nContinuation = nContinuation & 0x3;
+
+				if(bKeep && lrl > 4)
+				{
+					if(nDataSize + lrl > nBufSize)
+					{
+						int		nNewSize = nBufSize * 2 + lrl;
+						BYTE*	pNewBuf = new BYTE[nNewSize + 100];
+
+						memcpy(pNewBuf, pBuf, nDataSize);
+						delete[] pBuf;
+						pBuf = pNewBuf;
+						nBufSize = nNewSize;
+					}
+
+					reader.Read(pBuf + nDataSize, lrl - 4);
+					nDataSize += lrl - 4;
+					if(byteArr[2] & 0x4) nDataSize -= 2;
+					if(byteArr[2] & 0x2) nDataSize -= 2;
+				}
+				else
+					reader.Skip(lrl-4);
+			}
+		}
+
+		readScope.Stop();
+
+		if(bDFSR)
+		{
+			//DFSR dau tien truoc Logical File: giai ma tu bo dem
+			CLisPerfScope	dfsrScope(this->perfStats, LIS_PHASE_DFSR);
+
+			memset(pBuf + nDataSize, 0, 100);
+			this->ParseDataFormatSpecBytes(pBuf, nDataSize);
+			bHaveDFSR = true;
+		}
+		else if(bKeep)
+			run.Append(pBuf, nDataSize);
+
+		if(nFileType == FILE_TYPE_NTI)
+			if(reader.Tell()>= nFileSize-1) break;
+
+		if(nFileType == FILE_TYPE_LIS)
+			if(reader.Tell()>= nFileSize-12) break;
+
+		nLRNum++;
+		if(this->progressBar != NULL && (nLRNum & 0x3FF) == 0)
+			this->progressBar->SetPos((int)(100.0*reader.Tell()/nFileSize));
+	}
+
+	if(bInRun && !bError && run.Finish())
+		nConverted++;
+	if(run.bError)
+		bError = true;
+	if(run.bDecodeError)
+		this->ReportDecodeError();
+
+	reader.Detach();
+	delete[] pBuf;
+
+	if(bError)
+		return -1;
+
+	return nConverted;
 }
 
 void LISFileClass::ParseDataFormatSpecRecord(void)
 {
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_DFSR);
+
 	
 	this->ReleaseChansArr();
 
@@ -1283,18 +2066,18 @@ void LISFileClass::ParseDataFormatSpecRecord(void)
     bool bRecordNumPresence;
 
 	//Calculate TotalSize
-    nTotalSize = (int)this->lrArr[nIdx1].prArr[0].lLen - 6;
-    bFileNumPresence =  ((this->lrArr[nIdx1].prArr[0].attr1 & 0x4) > 0);
-    bRecordNumPresence = ((this->lrArr[nIdx1].prArr[0].attr1 & 0x2) > 0);
+    nTotalSize = (int)this->GetPRArr(nIdx1)[0].lLen - 6;
+    bFileNumPresence =  ((this->GetPRArr(nIdx1)[0].attr1 & 0x4) > 0);
+    bRecordNumPresence = ((this->GetPRArr(nIdx1)[0].attr1 & 0x2) > 0);
     if (bFileNumPresence) nTotalSize -= 2;
     if (bRecordNumPresence) nTotalSize -= 2;
 
-    for (int i = 1; i < this->lrArr[nIdx1].nPhysicalRecordNum; i++)
+    for (int i = 1; i < this->GetPRNum(nIdx1); i++)
     {
-        nTotalSize += (int)this->lrArr[nIdx1].prArr[i].lLen - 4;
+        nTotalSize += (int)this->GetPRArr(nIdx1)[i].lLen - 4;
 
-        bFileNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x4) > 0);
-        bRecordNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x2) > 0);
+        bFileNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x4) > 0);
+        bRecordNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x2) > 0);
         if (bFileNumPresence) nTotalSize -= 2;
         if (bRecordNumPresence) nTotalSize -= 2;
     }
@@ -1307,31 +2090,47 @@ void LISFileClass::ParseDataFormatSpecRecord(void)
 	////////////////////////////////////////////////////
 	//Read ByteArr
     nCurrentSize = 0;
-	fseek(hFile, this->lrArr[nIdx1].prArr[0].lAddress + 6, SEEK_SET);
-	fread(byteArr + nCurrentSize, sizeof(BYTE), (int)this->lrArr[nIdx1].prArr[0].lLen - 6, hFile);
+	this->ReadFileBytes(this->GetPRArr(nIdx1)[0].lAddress + 6, 
+		byteArr + nCurrentSize, (int)this->GetPRArr(nIdx1)[0].lLen - 6);
     //hFile.BaseStream.Seek(this.lrArr[nIdx1].prArr[0].lAddress + 6, SeekOrigin.Begin);
     //hFile.Read(byteArr, nCurrentSize, (int)this.lrArr[nIdx1].prArr[0].lLen - 6);
 
-    nCurrentSize = nCurrentSize + (int)this->lrArr[nIdx1].prArr[0].lLen - 6;
+    nCurrentSize = nCurrentSize + (int)this->GetPRArr(nIdx1)[0].lLen - 6;
     
-    bFileNumPresence = ((this->lrArr[nIdx1].prArr[0].attr1 & 0x4) > 0);
-    bRecordNumPresence = ((this->lrArr[nIdx1].prArr[0].attr1 & 0x2) > 0);
+    bFileNumPresence = ((this->GetPRArr(nIdx1)[0].attr1 & 0x4) > 0);
+    bRecordNumPresence = ((this->GetPRArr(nIdx1)[0].attr1 & 0x2) > 0);
     if (bFileNumPresence) nCurrentSize -= 2;
     if (bRecordNumPresence) nCurrentSize -= 2;
 
-    for (int i = 1; i < this->lrArr[nIdx1].nPhysicalRecordNum; i++)
+    for (int i = 1; i < this->GetPRNum(nIdx1); i++)
     {
-		fseek(hFile, this->lrArr[nIdx1].prArr[i].lAddress + 4, SEEK_SET);
-		fread(byteArr + nCurrentSize, sizeof(BYTE), (int)this->lrArr[nIdx1].prArr[i].lLen - 4, hFile);
+		this->ReadFileBytes(this->GetPRArr(nIdx1)[i].lAddress + 4, 
+			byteArr + nCurrentSize, (int)this->GetPRArr(nIdx1)[i].lLen - 4);
         //hFile.BaseStream.Seek(this.lrArr[nIdx1].prArr[i].lAddress + 4, SeekOrigin.Begin);
         //hFile.Read(byteArr, nCurrentSize, (int)this.lrArr[nIdx1].prArr[i].lLen - 4);
-        nCurrentSize = nCurrentSize + (int)this->lrArr[nIdx1].prArr[i].lLen - 4;
+        nCurrentSize = nCurrentSize + (int)this->GetPRArr(nIdx1)[i].lLen - 4;
 
-        bFileNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x4) > 0);
-        bRecordNumPresence = ((this->lrArr[nIdx1].prArr[i].attr1 & 0x2) > 0);
+        bFileNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x4) > 0);
+        bRecordNumPresence = ((this->GetPRArr(nIdx1)[i].attr1 & 0x2) > 0);
         if (bFileNumPresence) nCurrentSize -= 2;
         if (bRecordNumPresence) nCurrentSize -= 2;
     }
+
+	this->ParseDataFormatSpecBytes(byteArr, nTotalSize);
+
+	/////////////////////////////////////////////////////////
+	delete[] byteArr;
+}
+
+//////////////////////////////////////////////////////////////////
+// Giai ma du lieu DFSR (da bo header PR, nTotalSize byte) vao entryBlock
+// va chansArr. byteArr phai du them 100 byte sau nTotalSize (Entry Block
+// cuoi duoc doc truoc khi kiem tra kich thuoc).
+//////////////////////////////////////////////////////////////////
+void LISFileClass::ParseDataFormatSpecBytes(const BYTE* byteArr, int nTotalSize)
+{
+	this->ReleaseChansArr();
+
     ///////////////////////////////////////////////////////////
 	BYTE			nEntryBlockType;
 	BYTE			nSize;
@@ -1355,65 +2154,65 @@ void LISFileClass::ParseDataFormatSpecRecord(void)
         switch (nEntryBlockType)
         {
             case 1://DataRecordType
-				LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+				this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDataRecordType = ret.nValue;
                 break;
             case 2://DatumSpecBlockType
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDatumSpecBlockType = ret.nValue;
                 break;
             case 3://nDataFrameSize
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDataFrameSize = ret.nValue;
                 break;
             case 4://nDirection
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDirection = ret.nValue;
                 break;
             case 5://nOpticalDepthUnit
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nOpticalDepthUnit = ret.nValue;
                 break;
             case 6://fDataRefPoint
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.fDataRefPoint = ret.fValue;
                 break;
             case 7://strDataRefPointUnit
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.strDataRefPointUnit = ret.strValue;
                 break;
             case 8://fFrameSpacing
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.fFrameSpacing = ret.fValue;
                 break;
             case 9://strFrameSpacingUnit
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.strFrameSpacingUnit = ret.strValue;
                 break;
             case 10://Currently undefined
                 break;
             case 11://nMaxFramesPerRecord
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nMaxFramesPerRecord = ret.nValue;
                 break;
             case 12://fAbsentValue
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.fAbsentValue = ret.fValue;
                 break;
             case 13://nDepthRecordingMode
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDepthRecordingMode = ret.nValue;
                 break;
             case 14://strDepthUnit
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.strDepthUnit = ret.strValue;
                 break;
             case 15://nDepthRepr
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDepthRepr = ret.nValue;
                 break;
             case 16://nDatumSpecBlockSubType
-                LISMisc::ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
+                this->ReadReprCode(Entry, nSize, nReprCode, ret, nRealSize);
                 this->entryBlock.nDatumSpecBlockSubType = ret.nValue;
                 break;
         }
@@ -1502,26 +2301,110 @@ void LISFileClass::ParseDataFormatSpecRecord(void)
 		idx++;
     }
 
-	/////////////////////////////////////////////////////////
-	delete[] byteArr;
+	this->ApplyChannelSelection();
 }
 
-void LISFileClass::CreateDataSet(void)
+//////////////////////////////////////////////////////////////////
+// Chon cac kenh theo mnemonic (khong phan biet hoa thuong) va bat
+// bSelectiveLoad. Danh sach duoc giu rieng (selectChanArr) va dat lai
+// bLoad moi khi doc DFSR (ParseLogicalFile, ConvertStreaming, cac doi
+// tuong AttachIndex). Goi CreateDataSet sau do neu DFSR da duoc doc.
+// Tra ve so kenh cua DFSR hien tai duoc chon.
+//////////////////////////////////////////////////////////////////
+int LISFileClass::SelectChannels(const CArray<CString>& mnemonicArr)
 {
-	this->ReleaseDATASETArr();
-	//stepArr.RemoveAll();
+	this->selectChanArr.RemoveAll();
+	for(int i = 0; i<mnemonicArr.GetCount(); i++)
+	{
+		CString		str = mnemonicArr[i];
 
-    if (this->chansArr.GetCount() <= 0) return;
+		str.Trim();
+		this->selectChanArr.Add(str);
+	}
+	this->bSelectiveLoad = true;
 
-	CArray<int> NbSamplesArr;
-	CString		str, str1;
+	return this->ApplyChannelSelection();
+}
 
-	for(int i = 0; i<chansArr.GetCount(); i++)
-	{
-		int nNbSamples = chansArr[i].nNbSamples;
-		bool	bFound = false;
+//Dat bLoad cua chansArr theo selectChanArr (neu co). Tra ve so kenh duoc chon
+int LISFileClass::ApplyChannelSelection(void)
+{
+	int		nSelected = 0;
 
-		for(int j = 0; j<NbSamplesArr.GetCount(); j++)
+	for(int i = 0; i<this->chansArr.GetCount(); i++)
+	{
+		if(this->bSelectiveLoad && this->selectChanArr.GetCount() > 0)
+		{
+			CString		str = this->chansArr[i].strMnemonic;
+
+			str.Trim();
+			this->chansArr[i].bLoad = false;
+			for(int j = 0; j<this->selectChanArr.GetCount(); j++)
+				if(str.CompareNoCase(this->selectChanArr[j]) == 0)
+				{
+					this->chansArr[i].bLoad = true;
+					break;
+				}
+		}
+
+		if(this->IsChannelSelected(i))
+			nSelected++;
+	}
+
+	return nSelected;
+}
+
+//Danh sach kenh duoc chon: selectChanArr, hoac cac kenh co bLoad neu
+//chi chon bang bLoad (chua goi SelectChannels)
+void LISFileClass::GetChannelSelection(CArray<CString>& mnemonicArr)
+{
+	mnemonicArr.RemoveAll();
+
+	if(this->selectChanArr.GetCount() > 0)
+	{
+		for(int i = 0; i<this->selectChanArr.GetCount(); i++)
+			mnemonicArr.Add(this->selectChanArr[i]);
+		return;
+	}
+
+	for(int i = 0; i<this->chansArr.GetCount(); i++)
+	{
+		if(!this->chansArr[i].bLoad)
+			continue;
+
+		CString		str = this->chansArr[i].strMnemonic;
+
+		str.Trim();
+		mnemonicArr.Add(str);
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+// Nhom cac kenh theo nNbSamples thanh Dataset. bSelectiveLoad: chi cac
+// kenh co bLoad duoc dua vao Dataset (va duoc giai ma/ghi), cac kenh
+// khac co nDatasetIdx = -1. Goi lai sau khi doi bLoad.
+//////////////////////////////////////////////////////////////////
+void LISFileClass::CreateDataSet(void)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_DFSR);
+
+	this->ReleaseDATASETArr();
+	//stepArr.RemoveAll();
+	this->nMaxNbSamples = 0;
+
+    if (this->chansArr.GetCount() <= 0) return;
+
+	CArray<int> NbSamplesArr;
+	CString		str, str1;
+
+	for(int i = 0; i<chansArr.GetCount(); i++)
+	{
+		if(!this->IsChannelSelected(i)) continue;
+
+		int nNbSamples = chansArr[i].nNbSamples;
+		bool	bFound = false;
+
+		for(int j = 0; j<NbSamplesArr.GetCount(); j++)
 			if(NbSamplesArr[j] == nNbSamples)
 			{
 				bFound = true;
@@ -1531,6 +2414,8 @@ void LISFileClass::CreateDataSet(void)
 		if(bFound == false)	
 			NbSamplesArr.Add(nNbSamples);
 	}
+
+	if(NbSamplesArr.GetCount() == 0) return;//Khong chon kenh nao
 	
 	Dataset_t dataset;
 
@@ -1538,7 +2423,7 @@ void LISFileClass::CreateDataSet(void)
 	{
 		dataset.Init();
 
-		str.Format("Dataset_%d.dat", i);
+		str.Format("%sDataset_%d.dat", (LPCTSTR)this->strDATPrefix, i);
 		dataset.strDATFileName = this->strDirName + "\\" + str;
 		dataset.nNbSamples = NbSamplesArr[i];
 		dataset.nTotalItemNum = 0;
@@ -1547,6 +2432,9 @@ void LISFileClass::CreateDataSet(void)
 		DATASETArr.Add(dataset);
 	}
 
+	str.Format("%sColumns.lcol", (LPCTSTR)this->strDATPrefix);
+	this->strColumnFileName = this->strDirName + "\\" + str;
+
 	this->nMaxNbSamples = NbSamplesArr[0];
 	for(int i = 0; i<NbSamplesArr.GetCount(); i++)
 		if(NbSamplesArr[i] > this->nMaxNbSamples)
@@ -1569,6 +2457,14 @@ void LISFileClass::CreateDataSet(void)
 
 	for(int i = 0; i<chansArr.GetCount(); i++)
 	{
+		if(!this->IsChannelSelected(i))
+		{
+			chansArr[i].nDatasetIdx = -1;
+			chansArr[i].nIndexInDataset = -1;
+			chansArr[i].nPosInDataset = -1;
+			continue;
+		}
+
 		int nNbSamples = chansArr[i].nNbSamples;
 
 		for(int j = 0; j<NbSamplesArr.GetCount(); j++)
@@ -1588,199 +2484,865 @@ void LISFileClass::CreateDataSet(void)
 }
 
 
-void LISFileClass::CreateDATFiles(void)
+//Tao frame plan tu chansArr: moi (sample, kenh) la mot buoc giai ma.
+//Kenh khong thuoc Dataset nao (khong chon) bi bo qua: frame chi doc
+//cac byte cua kenh duoc chon.
+void LISFileClass::CreateFramePlan(void)
+{
+	FrameOp_t	op;
+
+	framePlanArr.RemoveAll();
+
+	for(int sample = 0; sample < this->nMaxNbSamples; sample++)
+	{
+		for(int chan = 0; chan < chansArr.GetCount(); chan++)
+		{
+			if(sample >= chansArr[chan].nNbSamples) continue;
+			if(chansArr[chan].nDatasetIdx < 0) continue;
+
+			op.nReprCode = chansArr[chan].nReprCode;
+			op.nCodeSize = LISMisc::GetReprCodeSize(op.nReprCode);
+			op.nCount = chansArr[chan].nDataItemNum;
+			op.nOffset = chansArr[chan].nOffsetInBytes + sample * op.nCount * op.nCodeSize;
+			op.bBatch = LISReprCode::IsBatchSupported(op.nReprCode);
+
+			op.nSample = sample;
+			op.nDataset = chansArr[chan].nDatasetIdx;
+			op.nColumn = 1 + chansArr[chan].nPosInDataset;
+
+			framePlanArr.Add(op);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+// Thong so giai ma frame cua Logical File hien tai: do sau, frame plan,
+// Dataset va huong do. pSampleOp do ham nay cap phat (nguoi goi giai phong).
+//////////////////////////////////////////////////////////////////
+void LISFileClass::InitDecodeCtx(FrameDecodeCtx_t& ctx, int*& pSampleOp)
+{
+	ctx.nLoggingDir = 1;
+	if(this->entryBlock.nDirection == 1)
+		ctx.nLoggingDir = -1;
+
+	if(this->entryBlock.nDepthRecordingMode == 0)//Depth in each frame
+	{
+		ctx.nDepthReprCode = chansArr[this->nDepthCurveIdx].nReprCode;
+		ctx.nDepthOffset = chansArr[this->nDepthCurveIdx].nOffsetInBytes;
+		ctx.bDepthInFrame = true;
+	}
+	else
+	{
+		ctx.nDepthReprCode = this->entryBlock.nDepthRepr;
+		ctx.nDepthOffset = 0;
+		ctx.bDepthInFrame = false;
+	}
+
+	//Frame plan va bo dem ghi (moi dong: do sau + cac kenh) cho moi Dataset
+	this->CreateFramePlan();
+
+	int				nOpNum = (int)framePlanArr.GetCount();
+	FrameOp_t*		pPlan = framePlanArr.GetData();
+
+	//Vi tri buoc dau tien cua moi sample trong frame plan
+	int				op = 0;
+
+	pSampleOp = new int[this->nMaxNbSamples + 1];
+	for(int sample = 0; sample <= this->nMaxNbSamples; sample++)
+	{
+		while(op < nOpNum && pPlan[op].nSample < sample) op++;
+		pSampleOp[sample] = op;
+	}
+
+	ctx.depthUnit = this->depthUnit;
+	ctx.pPlan = pPlan;
+	ctx.pSampleOp = pSampleOp;
+	ctx.pDatasets = DATASETArr.GetData();
+	ctx.nDatasetNum = (int)DATASETArr.GetCount();
+
+	ctx.nFrameValueNum = 0;
+	for(int d = 0; d < ctx.nDatasetNum; d++)
+		ctx.nFrameValueNum += ctx.pDatasets[d].nTotalItemNum*ctx.pDatasets[d].nNbSamples;
+
+	///////////////////////////////////////////////////////////////////////
+	// Trong truong hop huong do la UP can phai ghi file theo thu tu chieu sau tu tren xuong duoi:
+	// duyet Logical Rec, frame va sample theo thu tu nguoc lai, ghi truc tiep
+	ctx.bReverse = (this->entryBlock.nDirection == 1);
+}
+
+//Tra ve false neu khong co IFLR hoac khong tao/ghi duoc file DAT (file cot)
+bool LISFileClass::CreateDATFiles(void)
 {
 	CString			str;
 	int				nStartTime = GetTickCount();
 
+	//Khong co Logical File nao (file khong co IFLR)
+	if(this->lrIndex.pBlock == NULL || this->nFirstIFLR1 < 0 || this->DATASETArr.GetCount() == 0)
+		return false;
+
+	///////////////////////////////////////////////////////////////////////
+	FrameDecodeCtx_t	ctx;
+	int*				pSampleOp;
+	int					nLogRecSize;
+	int					nFrameNum;
+
+	if(this->progressBar != NULL)
+	{
+		this->progressBar->SetRange(0, this->nEndIFLR1- this->nFirstIFLR1);
+		this->progressBar->SetStep(1);
+		this->progressBar->SetPos(0);
+	}
+
+	this->InitDecodeCtx(ctx, pSampleOp);
+
+	int				nDatasetNum = ctx.nDatasetNum;
+	Dataset_t*		pDatasets = DATASETArr.GetData();
+	CLisDatWriter*	pWriterArr = new CLisDatWriter[nDatasetNum];
+	float**			pRowArr = new float*[nDatasetNum];
+	CLisColumnFile	columnFile;
+
+	int				nLogRecNum = this->nEndIFLR1 - this->nFirstIFLR1 + 1;
+	bool			bOK = true;
+	CLisPerfScope	openScope(this->perfStats, LIS_PHASE_WRITE);
+
+	if(this->bColumnOutput)
+	{
+		//Vi tri cac cot can so dong cua moi Dataset: tinh truoc tu chi muc PR
+		int*	pRowNum = new int[nDatasetNum];
+
+		for(int dataset = 0; dataset < nDatasetNum; dataset++)
+			pRowNum[dataset] = 0;
+
+		for(int i = this->nFirstIFLR1; i <= this->nEndIFLR1; i++)
+		{
+			nFrameNum = this->GetFrameNum(ctx, this->GetLogRecDataSize(i));
+			for(int dataset = 0; dataset < nDatasetNum; dataset++)
+				pRowNum[dataset] += nFrameNum * pDatasets[dataset].nNbSamples;
+		}
+
+		bOK = this->CreateColumnFile(columnFile, pRowNum);
+		delete[] pRowNum;
+
+		for(int i = 0; bOK && i<nDatasetNum; i++)
+			pWriterArr[i].AttachColumns(&columnFile, i, pDatasets[i].nTotalItemNum + 1);
+	}
+	else
+	{
+		for(int i = 0; bOK && i<nDatasetNum; i++)
+		{
+			pDatasets[i].hFile = fopen(pDatasets[i].strDATFileName, "wb");
+			bOK = (pDatasets[i].hFile != NULL);
+			pWriterArr[i].Attach(pDatasets[i].hFile, pDatasets[i].nTotalItemNum + 1);
+		}
+	}
+	openScope.Stop();
+
+	if(!bOK)
+	{
+		delete[] pWriterArr;
+		delete[] pRowArr;
+		delete[] pSampleOp;
+
+		for(int i = 0; i<nDatasetNum; i++)
+		{
+			if(pDatasets[i].hFile == NULL)
+				continue;
+			fclose(pDatasets[i].hFile);
+			pDatasets[i].hFile = NULL;
+		}
+		return false;
+	}
+
+	//Giai ma song song: file da anh xa -> cac thread doc thang tu vung anh xa;
+	//nguoc lai -> pipeline (thread doc file, cac thread giai ma, ghi theo thu tu)
+	int				nThreadNum = this->nDecodeThreadNum;
+	bool			bDone = false;
+	bool			bDecodeOK = true;//Cac thread khong hien thong bao: bao loi sau khi xong
+
+	if(nThreadNum <= 0)
+		nThreadNum = LISParallel::GetProcessorNum();
+	if(nLogRecNum < LIS_PARALLEL_MIN_LOGREC)
+		nThreadNum = 1;
+
+	this->pipelineStats.Init();
+
+	if(nThreadNum > 1)
+	{
+		//Doc, giai ma va ghi tren nhieu thread: do chung la LIS_PHASE_DECODE
+		CLisPerfScope	decodeScope(this->perfStats, LIS_PHASE_DECODE);
+
+		if(this->mappedFile.IsOpen())
+		{
+			bDecodeOK = this->DecodeLogRecsParallel(ctx, pWriterArr, nThreadNum);
+			bDone = true;
+		}
+		else
+			bDone = this->DecodeLogRecsPipeline(ctx, pWriterArr, nThreadNum, bDecodeOK);
+	}
+
+	if(bDone == false)
+	{
+		for(int n = 0; n < nLogRecNum; n++)
+		{
+			int		i = ctx.bReverse ? this->nEndIFLR1 - n : this->nFirstIFLR1 + n;
+
+			CLisPerfScope	readScope(this->perfStats, LIS_PHASE_READ);
+			nLogRecSize = this->ReadLogRecBytes(i);
+			readScope.Stop();
+
+			nFrameNum = this->GetFrameNum(ctx, nLogRecSize);
+
+			CLisPerfScope	writeScope(this->perfStats, LIS_PHASE_WRITE);
+			for(int dataset = 0; dataset < nDatasetNum; dataset++)
+				pRowArr[dataset] = pWriterArr[dataset].AppendRows(nFrameNum * pDatasets[dataset].nNbSamples);
+			writeScope.Stop();
+
+			CLisPerfScope	decodeScope(this->perfStats, LIS_PHASE_DECODE);
+			if(!this->DecodeLogRec(ctx, this->pLogRecBytes, nFrameNum, pRowArr))
+				bDecodeOK = false;
+			decodeScope.Stop();
+
+			this->perfStats.AddDecoded(1, nFrameNum, (LONGLONG)nFrameNum*ctx.nFrameValueNum);
+		
+			if(this->progressBar != NULL)
+			{
+				this->progressBar->StepIt();
+			}
+		}
+	}
+
+	if(this->progressBar != NULL)
+	{
+		this->progressBar->SetPos(0);
+	}
+
+	if(!bDecodeOK)
+		this->ReportDecodeError();
+
+	CLisPerfScope	closeScope(this->perfStats, LIS_PHASE_WRITE);
+
+	//Ghi phan con lai trong bo dem
+	for(int i = 0; i<nDatasetNum; i++)
+		if(!pWriterArr[i].Flush())
+			bOK = false;
+
+	delete[] pWriterArr;
+	delete[] pRowArr;
+	delete[] pSampleOp;
+
+	if(!columnFile.Close())
+		bOK = false;
 	for(int i = 0; i<DATASETArr.GetCount(); i++)
 	{
-		DATASETArr[i].hFile = fopen(DATASETArr[i].strDATFileName, "wb");
+		if(DATASETArr[i].hFile == NULL)
+			continue;
+		if(fclose(DATASETArr[i].hFile) != 0)
+			bOK = false;
+		DATASETArr[i].hFile = NULL;
 	}
 
-	///////////////////////////////////////////////////////////////////////
-	int				nLogRecSize;
-	int				nFrameNum;
-	
-	int				nCurPos;
-	float			fCurDepth = 0;
+	return bOK;
+}
+
+//////////////////////////////////////////////////////////////////
+// Tao file cot strColumnFileName voi bang Dataset/kenh lay tu
+// DATASETArr va chansArr (cung cach nhom kenh nhu cac file DAT).
+// pRowNum: so dong cua moi Dataset.
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::CreateColumnFile(CLisColumnFile& columnFile, const int* pRowNum)
+{
+	LISColumnDataset	dataset;
+	LISColumnChannel	chan;
+
+	columnFile.datasetArr.RemoveAll();
+	columnFile.channelArr.RemoveAll();
+
+	for(int i = 0; i<DATASETArr.GetCount(); i++)
+	{
+		memset(&dataset, 0, sizeof(dataset));
+		dataset.nNbSamples = DATASETArr[i].nNbSamples;
+		dataset.nTotalItemNum = DATASETArr[i].nTotalItemNum;
+		dataset.fStep = DATASETArr[i].fStep;
+		dataset.nRowNum = pRowNum[i];
+
+		columnFile.datasetArr.Add(dataset);
+	}
+
+	for(int i = 0; i<chansArr.GetCount(); i++)
+	{
+		if(chansArr[i].nDatasetIdx < 0)
+			continue;
+
+		memset(&chan, 0, sizeof(chan));
+		CLisColumnFile::SetName(chan.szMnemonic, chansArr[i].strMnemonic);
+		CLisColumnFile::SetName(chan.szUnits, chansArr[i].strUnits);
+		chan.nDatasetIdx = chansArr[i].nDatasetIdx;
+		chan.nIndexInDataset = chansArr[i].nIndexInDataset;
+		chan.nPosInDataset = chansArr[i].nPosInDataset;
+		chan.nDataItemNum = chansArr[i].nDataItemNum;
+		chan.nReprCode = chansArr[i].nReprCode;
+
+		columnFile.channelArr.Add(chan);
+	}
+
+	return columnFile.Create(this->strColumnFileName);
+}
+
+//////////////////////////////////////////////////////////////////
+// Chuyen cac file DAT da ghi xong (theo dong) sang file cot roi xoa
+// chung: dung khi khong biet truoc so dong (ConvertStreaming).
+// Tra ve false neu mot Dataset co hon INT_MAX dong.
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::ConvertDATToColumnFile(int nBufSize)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_WRITE);
+
+	int		nDatasetNum = (int)DATASETArr.GetCount();
+	int*	pRowNum = new int[nDatasetNum];
+	bool	bTooLarge = false;
+
+	for(int i = 0; i<nDatasetNum; i++)
+	{
+		FILE*	hDatFile = fopen(DATASETArr[i].strDATFileName, "rb");
+
+		pRowNum[i] = 0;
+		if(hDatFile == NULL)
+			continue;
+
+		_fseeki64(hDatFile, 0, SEEK_END);
+		__int64	nRowNum = _ftelli64(hDatFile) / ((DATASETArr[i].nTotalItemNum + 1) * (__int64)sizeof(float));
+		fclose(hDatFile);
+
+		//LISColumnDataset::nRowNum la int
+		if(nRowNum > INT_MAX)
+			bTooLarge = true;
+		else
+			pRowNum[i] = (int)nRowNum;
+	}
+
+	CLisColumnFile	columnFile;
+	bool			bOK = !bTooLarge && this->CreateColumnFile(columnFile, pRowNum);
+
+	delete[] pRowNum;
+
+	for(int i = 0; bOK && i<nDatasetNum; i++)
+		bOK = columnFile.WriteRowFile(i, DATASETArr[i].strDATFileName, nBufSize);
+
+	if(!columnFile.Close())
+		bOK = false;
+
+	if(bOK)
+	{
+		for(int i = 0; i<nDatasetNum; i++)
+			remove(DATASETArr[i].strDATFileName);
+	}
+
+	return bOK;
+}
+
+//////////////////////////////////////////////////////////////////
+// Tao chi muc do sau cho cac IFLR cua Logical File hien tai: chi doc
+// cac byte do sau cua frame dau tien (trong PR dau) cua moi Logical Rec.
+//////////////////////////////////////////////////////////////////
+void LISFileClass::CreateDepthIndex(void)
+{
+	CLisPerfScope	perfScope(this->perfStats, LIS_PHASE_DEPTH);
+
+	BYTE			byteArr[16];
 	ReprCodeReturn	ret;
 	int				nRealSize;
 	int				nDepthReprCode;
-	CString			strDepthUnits;
-	float			fValue;
-	bool			bDepthInFrame;
-	int				nLoggingDir = 1;
-	
-	if(this->entryBlock.nDirection == 1)
-		nLoggingDir = -1;
+	int				nDepthOffset;
+
+	this->depthIndex.RemoveAll();
+
+	if(this->lrIndex.pBlock == NULL || this->nFirstIFLR1 < 0 || this->nFrameSizeInBytes <= 0)
+		return;
 
 	if(this->entryBlock.nDepthRecordingMode == 0)//Depth in each frame
 	{
 		nDepthReprCode = chansArr[this->nDepthCurveIdx].nReprCode;
-		strDepthUnits = chansArr[this->nDepthCurveIdx].strUnits;
-		bDepthInFrame = true;
+		nDepthOffset = chansArr[this->nDepthCurveIdx].nOffsetInBytes;
 	}
 	else
 	{
-		strDepthUnits = this->entryBlock.strDepthUnit;
 		nDepthReprCode = this->entryBlock.nDepthRepr;
-		bDepthInFrame = false;
+		nDepthOffset = 0;
 	}
 
-	if(this->progressBar != NULL)
+	int		nDepthSize = LISMisc::GetReprCodeSize(nDepthReprCode);
+
+	if(nDepthSize <= 0 || nDepthSize > (int)sizeof(byteArr))
+		return;
+
+	//Do sau cua dung khoang IFLR nay da co trong file chi muc
+	int		nCachedNum = (int)this->cachedDepthArr.GetSize();
+
+	if(nCachedNum > 0 && nCachedNum == this->nEndIFLR1 - this->nFirstIFLR1 + 1 &&
+		this->cachedDepthArr[0].nRec == this->nFirstIFLR1)
 	{
-		this->progressBar->SetRange(0, this->nEndIFLR1- this->nFirstIFLR1);
-		this->progressBar->SetStep(1);
-		this->progressBar->SetPos(0);
+		for(int i = 0; i<nCachedNum; i++)
+		{
+			const LISDepthEntry&	entry = this->cachedDepthArr[i];
+			this->depthIndex.Add(entry.nRec, entry.fDepth, entry.nFrameNum);
+		}
+		this->depthIndex.Finish(this->fStep);
+		return;
 	}
 
-	for(int i = this->nFirstIFLR1; i<= this->nEndIFLR1; i++)
+	for(int i = this->nFirstIFLR1; i <= this->nEndIFLR1; i++)
 	{
-		nLogRecSize = this->ReadLogRecBytes(i);
+		int		nLogRecSize = this->GetLogRecDataSize(i);
+		int		nFrameNum;
+		float	fDepth;
 
-		if(this->entryBlock.nDepthRecordingMode == 0)//Depth in each frame
+		if(this->entryBlock.nDepthRecordingMode == 0)
 			nFrameNum = nLogRecSize/this->nFrameSizeInBytes;
-		else // Depth on log rec
-			nFrameNum = (nLogRecSize - LISMisc::GetReprCodeSize (this->entryBlock.nDepthRepr))/this->nFrameSizeInBytes;
-		
-		nCurPos = 0;
+		else
+			nFrameNum = (nLogRecSize - nDepthSize)/this->nFrameSizeInBytes;
 
-		if(this->entryBlock.nDepthRecordingMode == 1)//Depth appear only once in Log Rec;
+		//Do sau nam trong PR dau tien: doc rieng vai byte
+		int		nFirstPRSize = (int)this->GetPRArr(i)[0].lLen - 6;
+
+		if(this->GetPRArr(i)[0].attr1 & 0x4) nFirstPRSize -= 2;
+		if(this->GetPRArr(i)[0].attr1 & 0x2) nFirstPRSize -= 2;
+
+		if(nDepthOffset + nDepthSize <= nFirstPRSize)
+		{
+			this->ReadFileBytes(this->GetPRArr(i)[0].lAddress + 6 + nDepthOffset, byteArr, nDepthSize);
+			this->ReadReprCode(byteArr, nDepthSize, nDepthReprCode, ret, nRealSize);
+		}
+		else
+		{
+			this->ReadLogRecBytes(i);
+			this->ReadReprCode(this->pLogRecBytes, nDepthSize, nDepthReprCode, ret, nRealSize, nDepthOffset);
+		}
+
+		fDepth = ret.fValue;
+		fDepth = (float)this->depthUnit.Convert(fDepth);
+
+		this->depthIndex.Add(i, fDepth, (nFrameNum < 0) ? 0 : nFrameNum);
+	}
+
+	this->depthIndex.Finish(this->fStep);
+}
+
+//////////////////////////////////////////////////////////////////
+// Chi ghi cac Logical Rec co frame nam trong [fTop, fBottom] (m).
+// Khoang Logical Rec tim nhi phan tren depthIndex.
+// Tra ve false neu khong co Logical Rec nao trong khoang hoac ghi loi.
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::CreateDATFiles(double fTop, double fBottom)
+{
+	int		nFirst;
+	int		nLast;
+
+	if(!this->depthIndex.FindRange(fTop, fBottom, nFirst, nLast))
+		return false;
+
+	int		nOldFirstIFLR1 = this->nFirstIFLR1;
+	int		nOldEndIFLR1 = this->nEndIFLR1;
+
+	this->nFirstIFLR1 = nFirst;
+	this->nEndIFLR1 = nLast;
+
+	bool	bOK = this->CreateDATFiles();
+
+	this->nFirstIFLR1 = nOldFirstIFLR1;
+	this->nEndIFLR1 = nOldEndIFLR1;
+
+	return bOK;
+}
+
+//So frame trong Logical Rec co nLogRecSize byte du lieu
+int LISFileClass::GetFrameNum(const FrameDecodeCtx_t& ctx, int nLogRecSize)
+{
+	int		nFrameNum;
+
+	if(ctx.bDepthInFrame)//Depth in each frame
+		nFrameNum = nLogRecSize/this->nFrameSizeInBytes;
+	else // Depth on log rec
+		nFrameNum = (nLogRecSize - LISMisc::GetReprCodeSize(ctx.nDepthReprCode))/this->nFrameSizeInBytes;
+
+	if(nFrameNum < 0)
+		nFrameNum = 0;
+
+	return nFrameNum;
+}
+
+//////////////////////////////////////////////////////////////////
+// Giai ma nFrameNum frame cua mot Logical Rec (pBytes) vao cac dong
+// lien tiep cua tung Dataset: pRowArr[dataset] la dong dau tien,
+// co nFrameNum * nNbSamples dong. Chi doc ctx va cac thong so cua
+// Logical File nen co the goi dong thoi tu nhieu thread: khong hien
+// thong bao, tra ve false neu gap ma khong ho tro (nguoi goi bao loi).
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::DecodeLogRec(const FrameDecodeCtx_t& ctx, const BYTE* pBytes, int nFrameNum, float** pRowArr)
+{
+	const FrameOp_t*	pPlan = ctx.pPlan;
+	const Dataset_t*	pDatasets = ctx.pDatasets;
+	int					nDatasetNum = ctx.nDatasetNum;
+	int					nDepthSize = LISMisc::GetReprCodeSize(ctx.nDepthReprCode);
+	int					nCurPos = 0;
+	float				fCurDepth = 0;
+	ReprCodeReturn		ret;
+	int					nRealSize;
+	float*				pRows[64];
+	float**				pCurRow = (nDatasetNum <= 64) ? pRows : new float*[nDatasetNum];
+	bool				bOK = true;
+
+	for(int dataset = 0; dataset < nDatasetNum; dataset++)
+		pCurRow[dataset] = pRowArr[dataset];
+
+	if(ctx.bDepthInFrame == false)//Depth appear only once in Log Rec;
+	{
+		if(LISMisc::ReadReprCode(pBytes, nDepthSize, ctx.nDepthReprCode, ret, nRealSize, nCurPos, false) == 0)
+			bOK = false;
+		fCurDepth = ret.fValue;
+		fCurDepth = (float)ctx.depthUnit.Convert(fCurDepth);
+	}
+
+	int		framePos;
+	for(int f = 0; f<nFrameNum; f++)
+	{
+		int		frame = ctx.bReverse ? nFrameNum - 1 - f : f;
+
+		framePos = frame * this->nFrameSizeInBytes;
+		if(ctx.bDepthInFrame == false) framePos = framePos + nDepthSize;
+
+		if(ctx.bDepthInFrame == true)
 		{
-			LISMisc::ReadReprCode(this->pBytesBuf, LISMisc::GetReprCodeSize(nDepthReprCode), 
-					nDepthReprCode, ret, nRealSize, nCurPos);
-			//nCurPos += nRealSize;
+			nCurPos = framePos + ctx.nDepthOffset;
+			if(LISMisc::ReadReprCode(pBytes, nDepthSize, ctx.nDepthReprCode, ret, nRealSize, nCurPos, false) == 0)
+				bOK = false;
 			fCurDepth = ret.fValue;
-			fCurDepth = LISMisc::ConvertDepthValue(fCurDepth, strDepthUnits, "m");
+			fCurDepth = (float)ctx.depthUnit.Convert(fCurDepth);
 		}
 
-		int		framePos;
-		for(int frame = 0; frame<nFrameNum; frame++)
+		const BYTE*	pFrame = pBytes + framePos;
+
+		for(int smp = 0; smp < this->nMaxNbSamples; smp++)
 		{
-			framePos = frame * this->nFrameSizeInBytes;
-			if(bDepthInFrame == false) framePos = framePos + LISMisc::GetReprCodeSize(nDepthReprCode);
+			int		sample = ctx.bReverse ? this->nMaxNbSamples - 1 - smp : smp;
 
-			if(bDepthInFrame == true)
+			//Giai ma du lieu cua sample vao dong cua tung Dataset (chay frame plan)
+			for(int op = ctx.pSampleOp[sample]; op < ctx.pSampleOp[sample + 1]; op++)
 			{
-				nCurPos = framePos + chansArr[this->nDepthCurveIdx].nOffsetInBytes;
-				LISMisc::ReadReprCode(this->pBytesBuf, LISMisc::GetReprCodeSize(nDepthReprCode), 
-					nDepthReprCode, ret, nRealSize, nCurPos);
-				fCurDepth = ret.fValue;
-				fCurDepth = LISMisc::ConvertDepthValue(fCurDepth, strDepthUnits, "m");
-			}
+				float*	pDst = pCurRow[pPlan[op].nDataset] + pPlan[op].nColumn;
 
-			for(int sample = 0; sample < this->nMaxNbSamples; sample++)
-			{
-				//Ghi do sau (Write Depth)
-				for(int dataset = 0; dataset < DATASETArr.GetCount(); dataset++)
+				if(pPlan[op].bBatch)
 				{
-					if(sample >= DATASETArr[dataset].nNbSamples) continue;
-
-					float   fDepth;
-					//float	fStep = DATASETArr[dataset].fStep;
-
-					if(bDepthInFrame == false) ////Depth appear only once in Log Rec;
-						fDepth = fCurDepth + frame * this->fStep * nLoggingDir + 
-									sample * DATASETArr[dataset].fStep;
-					else//Depth in frame
-						//fDepth = fCurDepth + sample * DATASETArr[dataset].fStep;
-						fDepth = fCurDepth + sample * DATASETArr[dataset].fStep * nLoggingDir;
-					//str.Format("%8.3f ", fDepth);
-					//fwrite(str, 1, str.GetLength(), DATASETArr[dataset].hFile);
-					fwrite(&fDepth, sizeof(float), 1, DATASETArr[dataset].hFile);
+					LISReprCode::DecodeBatch(pFrame + pPlan[op].nOffset, pPlan[op].nReprCode,
+						pPlan[op].nCount, pDst);
 				}
-
-				//Ghi du lieu (Write Data)
-				for(int chan = 0; chan <chansArr.GetCount(); chan++)
+				else
 				{
-					if(sample >= chansArr[chan].nNbSamples) continue;
-					//if(chan == 1) continue;
-
-					int firstItemPos = chansArr[chan].nOffsetInBytes + 
-						sample * chansArr[chan].nDataItemNum * LISMisc::GetReprCodeSize(chansArr[chan].nReprCode);
-					firstItemPos = firstItemPos + framePos;
-					nCurPos = firstItemPos;
-
-					for(int item = 0; item < chansArr[chan].nDataItemNum; item++)
+					nCurPos = framePos + pPlan[op].nOffset;
+					for(int item = 0; item < pPlan[op].nCount; item++)
 					{
-						LISMisc::ReadReprCode(this->pBytesBuf,
-							LISMisc::GetReprCodeSize(chansArr[chan].nReprCode),
-							chansArr[chan].nReprCode, ret, nRealSize, nCurPos);
-						chansArr[chan].fData[item] = ret.fValue;
+						if(LISMisc::ReadReprCode(pBytes, pPlan[op].nCodeSize,
+							pPlan[op].nReprCode, ret, nRealSize, nCurPos, false) == 0)
+							bOK = false;
+						pDst[item] = ret.fValue;
 						nCurPos += nRealSize;
 					}
-					fwrite(chansArr[chan].fData, sizeof(float), chansArr[chan].nDataItemNum, 
-								DATASETArr[chansArr[chan].nDatasetIdx].hFile);
 				}
 			}
-		}
-	
-		if(this->progressBar != NULL)
-		{
-			this->progressBar->StepIt();
+
+			//Ghi do sau (Write Depth), chuyen sang dong tiep theo
+			for(int dataset = 0; dataset < nDatasetNum; dataset++)
+			{
+				if(sample >= pDatasets[dataset].nNbSamples) continue;
+
+				float   fDepth;
+
+				if(ctx.bDepthInFrame == false) ////Depth appear only once in Log Rec;
+					fDepth = fCurDepth + frame * this->fStep * ctx.nLoggingDir + 
+								sample * pDatasets[dataset].fStep;
+				else//Depth in frame
+					fDepth = fCurDepth + sample * pDatasets[dataset].fStep * ctx.nLoggingDir;
+
+				pCurRow[dataset][0] = fDepth;
+				pCurRow[dataset] += pDatasets[dataset].nTotalItemNum + 1;
+			}
 		}
 	}
-	if(this->progressBar != NULL)
+
+	if(pCurRow != pRows)
+		delete[] pCurRow;
+
+	return bOK;
+}
+
+class LISDecodeJob
+{
+public:
+	LISFileClass*			pLis;
+	const FrameDecodeCtx_t*	pCtx;
+
+	const int*				pLRIdx;//Logical Rec cua moi vi tri trong dot
+	const int*				pFrameNum;
+	float**					pRowStart;//[vi tri * nDatasetNum + dataset]: dong dau tien
+	int						nPosNum;
+	int						nChunkSize;
+	volatile LONG			nErrorNum;//So Logical Rec co ma khong giai ma duoc
+};
+
+//Moi viec giai ma mot doan Logical Rec lien tiep voi bo dem byte rieng
+static void LISDecodeChunkProc(int nIdx, void* pParam)
+{
+	LISDecodeJob*	pJob = (LISDecodeJob*)pParam;
+	int				nDatasetNum = pJob->pCtx->nDatasetNum;
+	int				nFirst = nIdx * pJob->nChunkSize;
+	int				nLast = nFirst + pJob->nChunkSize;
+	BYTE*			pBuf = new BYTE[pJob->pLis->nLogRecMaxSize];
+	const BYTE*		pBytes;
+
+	if(nLast > pJob->nPosNum)
+		nLast = pJob->nPosNum;
+
+	for(int pos = nFirst; pos < nLast; pos++)
 	{
-		this->progressBar->SetPos(0);
+		pJob->pLis->ReadLogRecBytes(pJob->pLRIdx[pos], pBuf, pBytes);
+		if(!pJob->pLis->DecodeLogRec(*pJob->pCtx, pBytes, pJob->pFrameNum[pos],
+			pJob->pRowStart + pos * nDatasetNum))
+			InterlockedIncrement(&pJob->nErrorNum);
 	}
 
-	for(int i = 0; i<DATASETArr.GetCount(); i++)
+	delete[] pBuf;
+}
+
+//////////////////////////////////////////////////////////////////
+// Giai ma song song theo tung dot (LIS_DECODE_BATCHSIZE byte):
+// so frame cua moi Logical Rec tinh tu chi muc PR, cong don ra vi tri
+// dung vi tri do. Bo dem ghi xuong file theo thu tu tren thread goi ham.
+// Tra ve false neu mot thread gap ma khong giai ma duoc.
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::DecodeLogRecsParallel(const FrameDecodeCtx_t& ctx, CLisDatWriter* pWriterArr, int nThreadNum)
+{
+	int				nDatasetNum = ctx.nDatasetNum;
+	int				nLogRecNum = this->nEndIFLR1 - this->nFirstIFLR1 + 1;
+	int*			pLRIdx = new int[nLogRecNum];
+	int*			pFrameNum = new int[nLogRecNum];
+	float**			pRowStart = new float*[nLogRecNum * nDatasetNum];
+	int*			pRowNum = new int[nDatasetNum];
+	LISDecodeJob	job;
+
+	job.pLis = this;
+	job.pCtx = &ctx;
+	job.nErrorNum = 0;
+
+	int		n = 0;
+	while(n < nLogRecNum)
 	{
-		fclose(DATASETArr[i].hFile);	
-		DATASETArr[i].hFile = NULL;
+		//Chon dot Logical Rec va tinh so frame (chi doc chi muc)
+		int		nFirst = n;
+		long	lBytes = 0;
+
+		for(int dataset = 0; dataset < nDatasetNum; dataset++)
+			pRowNum[dataset] = 0;
+
+		while(n < nLogRecNum && (n == nFirst || lBytes < LIS_DECODE_BATCHSIZE))
+		{
+			int		i = ctx.bReverse ? this->nEndIFLR1 - n : this->nFirstIFLR1 + n;
+			int		nLogRecSize = this->GetLogRecDataSize(i);
+
+			pLRIdx[n] = i;
+			pFrameNum[n] = this->GetFrameNum(ctx, nLogRecSize);
+			for(int dataset = 0; dataset < nDatasetNum; dataset++)
+				pRowNum[dataset] += pFrameNum[n] * ctx.pDatasets[dataset].nNbSamples;
+
+			lBytes += nLogRecSize;
+			n++;
+		}
+
+		//Cap vung dong cho ca dot, cong don vi tri cua tung Logical Rec
+		for(int dataset = 0; dataset < nDatasetNum; dataset++)
+		{
+			int		nRowSize = ctx.pDatasets[dataset].nTotalItemNum + 1;
+			float*	pRows = pWriterArr[dataset].AppendRows(pRowNum[dataset]);
+
+			for(int pos = nFirst; pos < n; pos++)
+			{
+				pRowStart[pos * nDatasetNum + dataset] = pRows;
+				pRows += pFrameNum[pos] * ctx.pDatasets[dataset].nNbSamples * nRowSize;
+			}
+		}
+
+		int		nPosNum = n - nFirst;
+		int		nChunkNum = nThreadNum * 4;
+
+		if(nChunkNum > nPosNum)
+			nChunkNum = nPosNum;
+
+		job.pLRIdx = pLRIdx + nFirst;
+		job.pFrameNum = pFrameNum + nFirst;
+		job.pRowStart = pRowStart + nFirst * nDatasetNum;
+		job.nPosNum = nPosNum;
+		job.nChunkSize = (nPosNum + nChunkNum - 1) / nChunkNum;
+
+		//Cac thread doc khong cap nhat perfStats: cong cho ca dot o day
+		bool	bPerfEnabled = this->perfStats.bEnabled;
+
+		this->perfStats.bEnabled = false;
+		LISParallel::For((nPosNum + job.nChunkSize - 1) / job.nChunkSize,
+			LISDecodeChunkProc, &job, nThreadNum);
+		this->perfStats.bEnabled = bPerfEnabled;
+
+		if(bPerfEnabled)
+		{
+			int		nBatchFrameNum = 0;
+
+			for(int pos = nFirst; pos < n; pos++)
+				nBatchFrameNum += pFrameNum[pos];
+
+			this->perfStats.AddRead(lBytes, 0);
+			this->perfStats.AddDecoded(nPosNum, nBatchFrameNum, (LONGLONG)nBatchFrameNum*ctx.nFrameValueNum);
+		}
+
+		if(this->progressBar != NULL)
+			this->progressBar->SetPos(n);
 	}
 
-	///////////////////////////////////////////////////////////////////////
-	// Trong truong hop huong do la UP can phai ghi file theo thu tu chieu sau tu tren xuong duoi
+	delete[] pLRIdx;
+	delete[] pFrameNum;
+	delete[] pRowStart;
+	delete[] pRowNum;
+
+	return (job.nErrorNum == 0);
+}
+
+
+
+
+class LISPipelineJob
+{
+public:
+	LISFileClass*			pLis;
+	const FrameDecodeCtx_t*	pCtx;
+
+	BYTE**					pBufArr;//Bo dem byte cua moi slot
+	const BYTE**			pBytesArr;//Du lieu Logical Rec cua moi slot
+	int*					pFrameNumArr;
+	float**					pRowsArr;//[slot * nDatasetNum + dataset]: cac dong da giai ma
+	int*					pRowsCapArr;//Suc chua (so float) cua pRowsArr
+	volatile LONG			nErrorNum;//So Logical Rec co ma khong giai ma duoc
+};
+
+//Cong doan doc: doc Logical Rec vao bo dem cua slot (chi thread doc dung hFile)
+static void LISPipelineReadProc(int nItem, int nSlot, void* pParam)
+{
+	LISPipelineJob*			pJob = (LISPipelineJob*)pParam;
+	LISFileClass*			pLis = pJob->pLis;
+	const FrameDecodeCtx_t*	pCtx = pJob->pCtx;
+	int						i = pCtx->bReverse ? pLis->nEndIFLR1 - nItem : pLis->nFirstIFLR1 + nItem;
+	int						nLogRecSize;
+
+	nLogRecSize = pLis->ReadLogRecBytes(i, pJob->pBufArr[nSlot], pJob->pBytesArr[nSlot]);
+	pJob->pFrameNumArr[nSlot] = pLis->GetFrameNum(*pCtx, nLogRecSize);
 
-	if(this->entryBlock.nDirection == 1) //UP
+	for(int dataset = 0; dataset < pCtx->nDatasetNum; dataset++)
 	{
-		FILE*	hTempFile;
-		CString	strTempFileName;
-		float	fDepth;
-		float*	fData = new float[200000];
+		int		idx = nSlot * pCtx->nDatasetNum + dataset;
+		int		nSize = pJob->pFrameNumArr[nSlot] * pCtx->pDatasets[dataset].nNbSamples *
+						(pCtx->pDatasets[dataset].nTotalItemNum + 1);
 
-		for(int i = 0; i<DATASETArr.GetCount(); i++)
+		if(nSize > pJob->pRowsCapArr[idx])
 		{
-			
-			DATASETArr[i].hFile = fopen(DATASETArr[i].strDATFileName, "rb");
+			delete[] pJob->pRowsArr[idx];
+			pJob->pRowsArr[idx] = new float[nSize];
+			pJob->pRowsCapArr[idx] = nSize;
+		}
+	}
+}
+
+//Cong doan giai ma
+static void LISPipelineDecodeProc(int nItem, int nSlot, void* pParam)
+{
+	LISPipelineJob*	pJob = (LISPipelineJob*)pParam;
+
+	if(!pJob->pLis->DecodeLogRec(*pJob->pCtx, pJob->pBytesArr[nSlot], pJob->pFrameNumArr[nSlot],
+		pJob->pRowsArr + nSlot * pJob->pCtx->nDatasetNum))
+		InterlockedIncrement(&pJob->nErrorNum);
+}
+
+//////////////////////////////////////////////////////////////////
+// Doc file (khong anh xa) tren mot thread, giai ma tren nThreadNum
+// thread, thread goi ham chep ket qua vao bo dem ghi theo thu tu.
+// Thong ke stall luu o pipelineStats. Tra ve false neu khong tao duoc
+// pipeline (nguoi goi chay tuan tu). bDecodeOK: false neu mot thread
+// gap ma khong giai ma duoc.
+//////////////////////////////////////////////////////////////////
+bool LISFileClass::DecodeLogRecsPipeline(const FrameDecodeCtx_t& ctx, CLisDatWriter* pWriterArr, int nThreadNum, bool& bDecodeOK)
+{
+	int				nDatasetNum = ctx.nDatasetNum;
+	int				nLogRecNum = this->nEndIFLR1 - this->nFirstIFLR1 + 1;
+	int				nDepth = this->nPipelineDepth;
+	LISPipelineJob	job;
+	CLisPipeline	pipeline;
+
+	if(nDepth < 2)
+		nDepth = 2;
+
+	job.pLis = this;
+	job.pCtx = &ctx;
+	job.pBufArr = new BYTE*[nDepth];
+	job.pBytesArr = new const BYTE*[nDepth];
+	job.pFrameNumArr = new int[nDepth];
+	job.pRowsArr = new float*[nDepth * nDatasetNum];
+	job.pRowsCapArr = new int[nDepth * nDatasetNum];
+	job.nErrorNum = 0;
+
+	for(int slot = 0; slot < nDepth; slot++)
+		job.pBufArr[slot] = new BYTE[this->nLogRecMaxSize];
+	for(int i = 0; i < nDepth * nDatasetNum; i++)
+	{
+		job.pRowsArr[i] = NULL;
+		job.pRowsCapArr[i] = 0;
+	}
+
+	bool	bStarted = pipeline.Start(nLogRecNum, LISPipelineReadProc, LISPipelineDecodeProc, &job,
+								nDepth, nThreadNum);
 
-			strTempFileName = 	DATASETArr[i].strDATFileName + "temp";
-			hTempFile = fopen(strTempFileName, "wb");
+	if(bStarted)
+	{
+		//Cong doan ghi: lay Logical Rec theo thu tu
+		for(int n = 0; n < nLogRecNum; n++)
+		{
+			int		slot = pipeline.WaitItem(n);
 
-			fseek(DATASETArr[i].hFile, 0, SEEK_END);
-			int nRecordNum = ftell(DATASETArr[i].hFile);
-			nRecordNum = (float)nRecordNum/((DATASETArr[i].nTotalItemNum + 1)*sizeof(float));
+			this->perfStats.AddDecoded(1, job.pFrameNumArr[slot], (LONGLONG)job.pFrameNumArr[slot]*ctx.nFrameValueNum);
 
-			
-			for(int j = nRecordNum-1; j>= 0; j--)
+			for(int dataset = 0; dataset < nDatasetNum; dataset++)
 			{
-				
-				fseek(DATASETArr[i].hFile, (DATASETArr[i].nTotalItemNum + 1)*sizeof(float)*j, SEEK_SET);
-
-				//Read Source file
-				fread(&fDepth, sizeof(float), 1, DATASETArr[i].hFile);
-				fread(fData, sizeof(float), DATASETArr[i].nTotalItemNum, DATASETArr[i].hFile);
-				
-				//Write destination file
-				fwrite(&fDepth, sizeof(float), 1, hTempFile);
-				fwrite(fData, sizeof(float), DATASETArr[i].nTotalItemNum, hTempFile);
+				int		nRowNum = job.pFrameNumArr[slot] * ctx.pDatasets[dataset].nNbSamples;
+
+				memcpy(pWriterArr[dataset].AppendRows(nRowNum), job.pRowsArr[slot * nDatasetNum + dataset],
+					nRowNum * (ctx.pDatasets[dataset].nTotalItemNum + 1) * sizeof(float));
 			}
-			
-			fclose(hTempFile);
 
-			fclose(DATASETArr[i].hFile);	
-			DATASETArr[i].hFile = NULL;
+			pipeline.ReleaseItem(n);
 
-			DeleteFile(DATASETArr[i].strDATFileName);
-			MoveFile(strTempFileName, DATASETArr[i].strDATFileName);
+			if(this->progressBar != NULL)
+				this->progressBar->StepIt();
 		}
 
-		delete[] fData;
+		pipeline.Stop();
+		this->pipelineStats = pipeline.stats;
 	}
-}
 
+	bDecodeOK = (job.nErrorNum == 0);
 
+	for(int slot = 0; slot < nDepth; slot++)
+		delete[] job.pBufArr[slot];
+	for(int i = 0; i < nDepth * nDatasetNum; i++)
+		delete[] job.pRowsArr[i];
 
+	delete[] job.pBufArr;
+	delete[] job.pBytesArr;
+	delete[] job.pFrameNumArr;
+	delete[] job.pRowsArr;
+	delete[] job.pRowsCapArr;
+
+	return bStarted;
+}
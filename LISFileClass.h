@@ -1,5 +1,10 @@
 #pragma once
 
+#include "LisBlockReader.h"
+#include "LisPipeline.h"
+#include "LisDepthIndex.h"
+#include "LisPerfStats.h"
+
 #define LRTYPE_NORMALDATA  0
 #define LRTYPE_JOBID  32
 #define LRTYPE_WELLSITEDATA  34
@@ -24,32 +29,50 @@
 #define REPRCODE_73  73//32 bit 2's complement integer (size = 4);
 #define REPRCODE_79  79//16 bit 2's complement integer (size = 2;
 
-#define MAX_LOGICALFILENUM	10
-
 #define	FILE_TYPE_LIS		1
 #define	FILE_TYPE_NTI		2
 
+#define	LIS_DECODE_BATCHSIZE		(4*1024*1024)//So byte du lieu Logical Rec trong mot dot giai ma song song
+#define	LIS_PARALLEL_MIN_LOGREC		64//It hon so Logical Rec nay: giai ma tuan tu
+#define	LIS_STREAM_WINDOW			(16*1024*1024)//Bo nho dem (byte) cua ConvertStreaming
+
+class CLisDatWriter;
+class CLisColumnFile;
+
 
 class PhysicalRecord
 {
 public: 
-	long lLen;
-    long lAddress;
+	__int64 lLen;
+    __int64 lAddress;
 
     BYTE attr1;
     BYTE attr2;
 };
 
-class LogicalRecord
+//////////////////////////////////////////////////////////////////////
+// Chi muc Logical Record dang cot (struct of arrays): moi truong la mot
+// mang lien tuc, tat ca nam trong mot khoi pBlock. PR cua LR i la
+// prTable[pPRStart[i]] .. prTable[pPRStart[i+1]-1] (bang PR dung chung).
+//////////////////////////////////////////////////////////////////////
+class LogicalRecordIndex
 {
 public:
-	long lLen;
-    long lAddress;
+	__int64*	pLen;
+	__int64*	pAddress;
+	int*	pType;
+	int*	pPRStart;//nCount+1 phan tu
+	int		nCount;
+	int		nCapacity;
+	BYTE*	pBlock;
+public:
+	LogicalRecordIndex()	{ Detach(); }
 
-    int nType;
+	void	SetCapacity(int nNewCapacity);
+	void	Free();
+	void	Detach();//Bo cac con tro ma khong giai phong (chi muc muon)
 
-    int nPhysicalRecordNum;
-    PhysicalRecord* prArr;
+	int		GetPRNum(int nIdx) const	{ return this->pPRStart[nIdx+1] - this->pPRStart[nIdx]; }
 };
 
 class ReprCodeReturn
@@ -96,64 +119,34 @@ public:
 };
 
 
+//////////////////////////////////////////////////////////////////
+// Mot Logical File: khoang IFLR [nFirstIFLR1, nEndIFLR1] va cac EFLR
+// thuoc no (Job ID, Wellsite, DFSR, File Header/Trailer, Comment...).
+// Chi so cac EFLR nam lien nhau trong mang chung eflrIdxArr cua
+// LISFileClass: [nFirstEFLR, nFirstEFLR + nEFLRNum), theo thu tu LR.
+//////////////////////////////////////////////////////////////////
 class LogicalFile
 {
 public:
-	//int nStartIdx1;
-    //int nStartIdx2;
-    //int nEndIdx1;
-    //int nEndIdx2;
-
     int nFirstIFLR1;
-    //int nFirstIFLR2;
     int nEndIFLR1;
-    //int nEndIFLR2;
-
-    CArray<CPoint> JobIDPos;
-    CArray<CPoint> WellsiteDataPos ;
-    CArray<CPoint> ToolStringInfoPos ;
-    CArray<CPoint> TableDumpPos;
-    CArray<CPoint> DataFormatSpecPos ;
-    CArray<CPoint> FileHeaderPos;
-    CArray<CPoint> FileTrailerPos ;
-    CArray<CPoint> TapeHeaderPos ;
-    CArray<CPoint> TapeTrailerPos ;
-    CArray<CPoint> ReelHeaderPos ;
-    CArray<CPoint> ReelTrailerPos ;
-    CArray<CPoint> CommentPos ;
+
+	int nFirstEFLR;
+	int nEFLRNum;
     
 public:
     void Init()
     {
-        //nStartIdx1 = 0;
-        //nStartIdx2 = 0;
-        //nEndIdx1 = 0;
-        //nEndIdx2 = 0;
-
         nFirstIFLR1 = -1;
-        //nFirstIFLR2 = -1;
         nEndIFLR1 = -1;
-        //nEndIFLR2 = -1;
+
+		nFirstEFLR = 0;
+		nEFLRNum = 0;
     }
     LogicalFile()
     {
         Init();
     }
-    void ReleaseResources()
-    {
-        JobIDPos.RemoveAll();
-        WellsiteDataPos.RemoveAll();
-        ToolStringInfoPos.RemoveAll();
-        TableDumpPos.RemoveAll();
-        DataFormatSpecPos.RemoveAll();
-        FileHeaderPos.RemoveAll();
-        FileTrailerPos.RemoveAll();
-        TapeHeaderPos.RemoveAll();
-        TapeTrailerPos.RemoveAll();
-        ReelHeaderPos.RemoveAll();
-        ReelTrailerPos.RemoveAll();
-        CommentPos.RemoveAll(); 
-    }
 };
 
 
@@ -280,6 +273,46 @@ public:
 };
 
 
+//////////////////////////////////////////////////////////////
+// Mot buoc giai ma trong frame (frame plan): nCount gia tri ma
+// nReprCode bat dau tu byte nOffset cua frame, ghi vao cot nColumn
+// cua dong du lieu thuoc Dataset nDataset.
+// Plan duoc tao mot lan cho moi logical file (CreateFramePlan),
+// sap xep theo nSample roi theo thu tu kenh trong chansArr.
+//////////////////////////////////////////////////////////////
+class FrameOp_t
+{
+public:
+	int		nOffset;//Vi tri byte trong frame
+	int		nReprCode;
+	int		nCodeSize;
+	int		nCount;
+	bool	bBatch;//Ma duoc LISReprCode::DecodeBatch ho tro
+
+	int		nSample;
+	int		nDataset;
+	int		nColumn;//Cot trong dong du lieu (cot 0 la do sau)
+};
+
+//////////////////////////////////////////////////////////////
+// Don vi do sau da phan tich san (LISMisc::GetDepthUnit): doi sang
+// m chi con hai phep nhan, khong xu ly chuoi trong vong lap frame.
+//////////////////////////////////////////////////////////////
+class DepthUnit_t
+{
+public:
+	float	fFactor;//He so o dau don vi (".5MM", "0.1 IN")
+	double	fScale;//Don vi -> m (1: khong doi)
+public:
+	DepthUnit_t()
+	{
+		fFactor = 1;
+		fScale = 1;
+	}
+	//Cung thu tu phep tinh voi ConvertDepthValue
+	double Convert(double fDepth) const	{ return fFactor * fDepth * fScale; }
+};
+
 class Dataset_t
 {
 public:
@@ -322,14 +355,38 @@ public:
 };
 
 
+//////////////////////////////////////////////////////////////////
+// Thong so giai ma frame dung chung (chi doc) cho moi Logical Rec,
+// de cac thread co the giai ma nhieu Logical Rec cung luc.
+//////////////////////////////////////////////////////////////////
+class FrameDecodeCtx_t
+{
+public:
+	const FrameOp_t*	pPlan;
+	const int*			pSampleOp;//Buoc dau tien cua moi sample trong pPlan
+	const Dataset_t*	pDatasets;
+	int					nDatasetNum;
+
+	bool				bDepthInFrame;
+	int					nDepthOffset;//Vi tri do sau trong frame (bDepthInFrame)
+	int					nDepthReprCode;
+	DepthUnit_t			depthUnit;
+
+	bool				bReverse;//Huong UP: duyet frame va sample nguoc lai
+	int					nLoggingDir;
+	int					nFrameValueNum;//So gia tri giai ma moi frame (perfStats)
+};
+
 class LISMisc
 {
 public:
 	static int GetReprCodeSize(int nReprCode);
 	static CString FindLogicalRecordTypeName(int nType);
 	static double ConvertDepthValue(double fDepth, CString strOldDU, CString strNewDU);
-	static int ReadReprCode(BYTE byteArr[], int nCount, int nReprCode,
-                 ReprCodeReturn& ret, int& nRealSize, int nCurPos = 0);
+	static DepthUnit_t GetDepthUnit(CString strOldDU, CString strNewDU);
+	//Tra ve 0 neu ma khong ho tro (bShowError: hien thong bao; false tren worker thread)
+	static int ReadReprCode(const BYTE byteArr[], int nCount, int nReprCode,
+                 ReprCodeReturn& ret, int& nRealSize, int nCurPos = 0, bool bShowError = true);
     static long Convert4Bytes2Long(BYTE group[]);  
 };
 
@@ -339,20 +396,24 @@ public:
 	CString						strFileName;
 	CString						strDirName;
     FILE*						hFile;
-    long						nFileSize;
+    __int64						nFileSize;//_ftelli64: file > 2 GB
 	int							nFileType;//Russian or Halliburton
     CProgressCtrl				*progressBar;
 
-	LogicalRecord*				lrArr;
+	LogicalRecordIndex			lrIndex;
 	int							nLogicalRecordNum;
+	PhysicalRecord*				prTable;//PR cua tat ca cac LR (xem LogicalRecordIndex::pPRStart)
+	int							nPhysicalRecordNum;
 
-	LogicalFile					logicalFileArr[MAX_LOGICALFILENUM];
+	CArray<LogicalFile>			logicalFileArr;
+	CArray<int>					eflrIdxArr;//Chi so LR cua EFLR, cac Logical File noi tiep nhau
     int							nCurLogicalFile;
 	int							nLogicalFileNum;
 
 	CArray<Dataset_t>			DATASETArr;
 	EntryBlock_t				entryBlock;
 	CArray<DatumSpecBlock_t>	chansArr;
+	CArray<FrameOp_t>			framePlanArr;
 
     int							nFirstIFLR1;
     int							nEndIFLR1;
@@ -365,11 +426,33 @@ public:
 	int				nDepthCurveIdx;
 	int				nFrameSizeInBytes; // Kich thuoc tinh bang byte cua mot Frame du lieu
 	BYTE*			pBytesBuf;
+	const BYTE*		pLogRecBytes;//Du lieu cua LR vua doc (pBytesBuf hoac vung anh xa)
+
+	bool			bUseMappedFile;//Doc file qua memory mapping
+	bool			bUseIndexCache;//Doc/ghi bang LR/PR va do sau qua file chi muc (.lidx)
+	int				nDecodeThreadNum;//So thread giai ma trong CreateDATFiles (0: theo so CPU, 1: tuan tu)
+	bool			bShowErrors;//false: khong hien thong bao (doi tuong chay tren worker thread, xem bDecodeError)
+	bool			bDecodeError;//Gap ma bieu dien khong ho tro tu lan ParseLogicalFile/ConvertStreaming/ConvertAllLogicalFiles gan nhat
+	int				nPipelineDepth;//So slot cua pipeline doc/giai ma/ghi (file khong anh xa)
+	LISPipelineStats	pipelineStats;//Thong ke stall cua lan CreateDATFiles gan nhat
+	LISPerfStats	perfStats;//Thoi gian/I-O tung giai doan cua lan Parse/ConvertStreaming gan nhat (bEnabled)
+	CLisMappedFile	mappedFile;
+
+	LISFileClass*	pIndexSource;//!= NULL: lrIndex/prTable/logicalFileArr muon cua doi tuong nay
+	CString			strDATPrefix;//Tien to ten file DAT
+	bool			bSelectiveLoad;//Chi giai ma va ghi cac kenh co bLoad = true (CreateDataSet)
+	CArray<CString>	selectChanArr;//Mnemonic cac kenh duoc chon (SelectChannels): dat lai bLoad sau moi lan doc DFSR
+	bool			bColumnOutput;//Ghi file cot (CLisColumnFile) thay cho cac file Dataset_%d.dat
+	CString			strColumnFileName;//Ten day du cua file cot (<prefix>Columns.lcol)
 
 	double			fStep;//in meter
     double			fStartDepth;//in meter
     double			fEndDepth;//in meter
 
+	DepthUnit_t		depthUnit;//Don vi do sau cua Logical File hien tai (SetupFrameFormat)
+	CLisDepthIndex	depthIndex;//Do sau -> IFLR cua Logical File hien tai
+	CArray<LISDepthEntry>	cachedDepthArr;//Do sau doc tu file chi muc (CreateDepthIndex)
+
 	int				nMaxNbSamples;
 
 	////////////////////////////////////////////////////
@@ -390,21 +473,54 @@ public:
 	LISFileClass(void);
 	~LISFileClass(void);
 	void ParseBlankRecord(BYTE group2[], BYTE group3[], BYTE group4[], long &lPrevAddr, long &lNextAddr, long &lRecLen);
+	void OpenFile(void);
 	void Parse(void);
+	void ScanRecords(void);
+	bool LoadIndexCache(void);
+	bool SaveIndexCache(void);
 	void ReleaseResources(void);
 	//CString FindLogicalRecordTypeName(int nType);
 	void ReleaseEFLRArr(bool bAll=true);
 	int GetNextPR(int nLRNum, int nCurIdx1, int nCurIdx2, int& nNextIdx1, int& nNextIdx2);
 	int GetPrevPR(int nCurIdx1, int nCurIdx2, int& nPrevIdx1, int& nPrevIdx2);
+	PhysicalRecord* GetPRArr(int nLRIdx)	{ return this->prTable + this->lrIndex.pPRStart[nLRIdx]; }
+	int GetPRNum(int nLRIdx)				{ return this->lrIndex.GetPRNum(nLRIdx); }
 	void CreateLogicalFileArr(void);
 	void ParseLogicalFile(int nCurLF);
+	void AttachIndex(LISFileClass* pSrc);
+	int ConvertAllLogicalFiles(int nThreadNum = 0);
+	int ConvertStreaming(int nWindowSize = LIS_STREAM_WINDOW);
+	void SetupFrameFormat(void);
+	void InitDecodeCtx(FrameDecodeCtx_t& ctx, int*& pSampleOp);
 	void ParseDataFormatSpecRecord(void);
+	void ParseDataFormatSpecBytes(const BYTE* byteArr, int nTotalSize);
 	void CreateDataSet(void);
+	bool IsChannelSelected(int nChan)		{ return !this->bSelectiveLoad || this->chansArr[nChan].bLoad; }
+	int SelectChannels(const CArray<CString>& mnemonicArr);
+	int ApplyChannelSelection(void);
+	void GetChannelSelection(CArray<CString>& mnemonicArr);
 	double GetStartDepth(void);
 	double GetEndDepth(double fStep);
 	int GetExtraBytesInLogRec(int nLRIdx);
 	void ReleaseDATASETArr(void);
-	void CreateDATFiles(void);
+	void CreateFramePlan(void);
+	void CreateDepthIndex(void);
+	bool CreateDATFiles(void);
+	bool CreateDATFiles(double fTop, double fBottom);
+	bool CreateColumnFile(CLisColumnFile& columnFile, const int* pRowNum);
+	bool ConvertDATToColumnFile(int nBufSize);
+	int GetFrameNum(const FrameDecodeCtx_t& ctx, int nLogRecSize);
+	bool DecodeLogRec(const FrameDecodeCtx_t& ctx, const BYTE* pBytes, int nFrameNum, float** pRowArr);
+	bool DecodeLogRecsParallel(const FrameDecodeCtx_t& ctx, CLisDatWriter* pWriterArr, int nThreadNum);
+	bool DecodeLogRecsPipeline(const FrameDecodeCtx_t& ctx, CLisDatWriter* pWriterArr, int nThreadNum, bool& bDecodeOK);
+	int ReadReprCode(const BYTE byteArr[], int nCount, int nReprCode, ReprCodeReturn& ret, int& nRealSize, int nCurPos = 0);
+	void ReportDecodeError(void);
+	int GetLogRecDataSize(int nLRIdx);
 	int ReadLogRecBytes(int nLRIdx);
+	int ReadLogRecBytes(int nLRIdx, BYTE* pBuf, const BYTE*& pBytes);
+	bool ReadLogRecRange(int nLRIdx, int nOffset, BYTE* pDst, int nCount);
+	int ReadChannelSlice(int nChan, int nLRIdx, int nFrame, int nSample, float* pDst);
+	int ReadChannelSlice(int nChan, double fDepth, float* pDst);
+	void ReadFileBytes(__int64 lAddr, BYTE* pDst, int nCount);
 	void ReleaseChansArr(void);
 };
@@ -0,0 +1,76 @@
+// LisArena.h: interface for the CLisArena class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <new>
+
+#define		LIS_ARENA_BLOCKSIZE		4096//So doi tuong trong mot khoi
+
+//////////////////////////////////////////////////////////////////////
+// Cap phat doi tuong theo khoi lien tuc (arena): moi khoi chua
+// nBlockSize doi tuong T, New() chi lay o tiep theo trong khoi hien tai.
+// Khong giai phong tung doi tuong; RemoveAll() goi destructor cua tat
+// ca doi tuong roi giai phong cac khoi. Con tro tra ve on dinh den khi
+// RemoveAll() (dung cho cac bang CTypedPtrArray cua CLisFile).
+//////////////////////////////////////////////////////////////////////
+template<class T> class CLisArena
+{
+public:
+	CLisArena(int nBlockSize = LIS_ARENA_BLOCKSIZE)
+	{
+		this->nBlockSize = nBlockSize;
+		this->nUsed = nBlockSize;
+		this->nCount = 0;
+	}
+	~CLisArena()
+	{
+		RemoveAll();
+	}
+
+	//Doi tuong moi (constructor mac dinh)
+	T* New()
+	{
+		if(this->nUsed >= this->nBlockSize)
+		{
+			this->blockArr.Add(new BYTE[sizeof(T)*this->nBlockSize]);
+			this->nUsed = 0;
+		}
+
+		BYTE*	pBlock = this->blockArr[this->blockArr.GetSize()-1];
+		T*		pObj = ::new((void*)(pBlock + sizeof(T)*this->nUsed)) T;
+
+		this->nUsed++;
+		this->nCount++;
+		return pObj;
+	}
+
+	void RemoveAll()
+	{
+		int		nLeft = this->nCount;
+
+		for(int i = 0; i<this->blockArr.GetSize(); i++)
+		{
+			T*		pObj = (T*)this->blockArr[i];
+			int		nNum = (nLeft < this->nBlockSize) ? nLeft : this->nBlockSize;
+
+			for(int j = 0; j<nNum; j++)
+				pObj[j].~T();
+			nLeft -= nNum;
+
+			delete[] this->blockArr[i];
+		}
+		this->blockArr.RemoveAll();
+		this->nUsed = this->nBlockSize;
+		this->nCount = 0;
+	}
+
+	int GetCount() const	{ return this->nCount; }
+
+protected:
+	CArray<BYTE*>	blockArr;
+	int				nBlockSize;
+	int				nUsed;//So doi tuong da dung trong khoi cuoi
+	int				nCount;
+};
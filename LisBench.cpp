@@ -0,0 +1,507 @@
+// LisBench.cpp: implementation of the CLisBench class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include ".\lisfileclass.h"
+#include "LisBench.h"
+#include <math.h>
+
+#define		LIS_BENCH_BLANKSIZE		12//Blank record truoc moi PR cua file LIS
+
+volatile double CLisBench::fSink = 0;
+
+double CLisBench::GetTime()
+{
+	LARGE_INTEGER	freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+
+	return (double)count.QuadPart/(double)freq.QuadPart;
+}
+
+static DWORD NextBenchRandom(DWORD& nState)
+{
+	nState ^= nState << 13;
+	nState ^= nState >> 17;
+	nState ^= nState << 5;
+	return nState;
+}
+
+void CLisBench::FillRandom(BYTE* pDst, int nSize, DWORD& nState)
+{
+	for(int i = 0; i<nSize; i++)
+		pDst[i] = (BYTE)(NextBenchRandom(nState) >> 24);
+}
+
+int CLisBench::GetReprSize(int nReprCode)
+{
+	switch(nReprCode)
+	{
+	case 56: case 66:					return 1;
+	case 49: case 79:					return 2;
+	case 50: case 68: case 70: case 73:	return 4;
+	}
+	return 0;
+}
+
+//Ma 68 (32 bit floating point), big endian
+static void EncodeBench68(double fValue, BYTE pDst[4])
+{
+	DWORD	nWord = 0;
+
+	if(fValue != 0)
+	{
+		int		nExp;
+		double	fMantissa = frexp(fabs(fValue), &nExp);//[0.5, 1)
+		long	nFrac = (long)floor(fMantissa*(1 << 23) + 0.5);
+
+		if(nFrac >= (1 << 23))
+		{
+			nFrac >>= 1;
+			nExp++;
+		}
+
+		if(fValue > 0)
+			nWord = ((DWORD)(nExp + 128) << 23) | (DWORD)nFrac;
+		else
+			nWord = 0x80000000 | ((DWORD)(127 - nExp) << 23) | ((DWORD)(-nFrac) & 0x7FFFFF);
+	}
+
+	pDst[0] = (BYTE)(nWord >> 24);
+	pDst[1] = (BYTE)(nWord >> 16);
+	pDst[2] = (BYTE)(nWord >> 8);
+	pDst[3] = (BYTE)nWord;
+}
+
+static void AddBenchBytes(CArray<BYTE>& arr, const void* pSrc, int nSize)
+{
+	int		nPos = (int)arr.GetSize();
+
+	arr.SetSize(nPos + nSize);
+	memcpy(arr.GetData() + nPos, pSrc, nSize);
+}
+
+//Entry Block cua DFSR: type, size, ma, gia tri
+static void AddBenchEntry(CArray<BYTE>& arr, int nType, int nReprCode, const BYTE* pValue, int nSize)
+{
+	BYTE	head[3] = { (BYTE)nType, (BYTE)nSize, (BYTE)nReprCode };
+
+	AddBenchBytes(arr, head, 3);
+	AddBenchBytes(arr, pValue, nSize);
+}
+
+//Datum Spec Block (40 byte)
+static void AddBenchDatum(CArray<BYTE>& arr, const LISBenchChannel& chan)
+{
+	BYTE	blk[40];
+	int		nSize = CLisBench::GetReprSize(chan.nReprCode)*chan.nNbSamples*chan.nItemNum;
+	int		nMnemLen = (chan.strMnemonic.GetLength() < 4 ? chan.strMnemonic.GetLength() : 4);
+	int		nUnitLen = (chan.strUnits.GetLength() < 4 ? chan.strUnits.GetLength() : 4);
+
+	memset(blk, ' ', 22);
+	memset(blk + 22, 0, sizeof(blk) - 22);
+	memcpy(blk, (LPCTSTR)chan.strMnemonic, nMnemLen);
+	memcpy(blk + 4, "SRV", 3);//Service ID
+	memcpy(blk + 10, "ORD", 3);//Service Order Nb
+	memcpy(blk + 18, (LPCTSTR)chan.strUnits, nUnitLen);
+	blk[27] = 1;//File Nb
+	blk[28] = (BYTE)(nSize >> 8);
+	blk[29] = (BYTE)nSize;
+	blk[33] = (BYTE)chan.nNbSamples;
+	blk[34] = (BYTE)chan.nReprCode;
+
+	AddBenchBytes(arr, blk, sizeof(blk));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Ghi cac Logical Record ra file: chia thanh PR (toi da nMaxPRSize
+// byte ke ca header), file LIS co them blank record (4 byte 0, dia chi
+// PR truoc va PR sau, little endian) truoc moi PR.
+//////////////////////////////////////////////////////////////////////
+class LISBenchWriter
+{
+public:
+	FILE*	hFile;
+	bool	bNTI;
+	int		nMaxPRSize;
+	long	lAddr;//Dia chi PR tiep theo
+	long	lPrevAddr;
+	bool	bOK;
+public:
+	LISBenchWriter(FILE* hFile, const LISBenchConfig& config)
+	{
+		this->hFile = hFile;
+		this->bNTI = config.bNTI;
+		this->nMaxPRSize = (config.nMaxPRSize > 16 ? config.nMaxPRSize : 16);
+		this->lAddr = 0;
+		this->lPrevAddr = 0;
+		this->bOK = true;
+	}
+
+	void WritePR(int nType, bool bFirst, int nCont, const BYTE* pData, int nSize)
+	{
+		BYTE	head[LIS_BENCH_BLANKSIZE + 6];
+		int		nHeadSize = (bFirst ? 6 : 4);
+		int		nPRSize = nSize + nHeadSize;
+		int		nPos = 0;
+
+		if(!this->bNTI)
+		{
+			long	lNextAddr = this->lAddr + LIS_BENCH_BLANKSIZE + nPRSize;
+
+			memset(head, 0, 4);
+			for(int i = 0; i<4; i++)
+			{
+				head[4 + i] = (BYTE)(this->lPrevAddr >> (8*i));
+				head[8 + i] = (BYTE)(lNextAddr >> (8*i));
+			}
+			nPos = LIS_BENCH_BLANKSIZE;
+		}
+
+		head[nPos++] = (BYTE)(nPRSize >> 8);
+		head[nPos++] = (BYTE)nPRSize;
+		head[nPos++] = 0;
+		head[nPos++] = (BYTE)nCont;
+		if(bFirst)
+		{
+			head[nPos++] = (BYTE)nType;
+			head[nPos++] = 0;
+		}
+
+		if(fwrite(head, 1, nPos, this->hFile) != (size_t)nPos)
+			this->bOK = false;
+		if(nSize > 0 && fwrite(pData, 1, nSize, this->hFile) != (size_t)nSize)
+			this->bOK = false;
+
+		this->lPrevAddr = this->lAddr;
+		this->lAddr += nPos + nSize;
+	}
+
+	void WriteLogRec(int nType, const BYTE* pData, int nSize)
+	{
+		int		nFirst = (nSize < this->nMaxPRSize - 6 ? nSize : this->nMaxPRSize - 6);
+		int		nLeft = nSize - nFirst;
+
+		//Continuation: 0 - mot PR, 1 - PR dau, 3 - PR giua, 2 - PR cuoi
+		WritePR(nType, true, (nLeft > 0 ? 1 : 0), pData, nFirst);
+		pData += nFirst;
+
+		while(nLeft > 0)
+		{
+			int		nChunk = (nLeft < this->nMaxPRSize - 4 ? nLeft : this->nMaxPRSize - 4);
+
+			nLeft -= nChunk;
+			WritePR(nType, false, (nLeft > 0 ? 3 : 2), pData, nChunk);
+			pData += nChunk;
+		}
+	}
+
+	void WriteLogRec(int nType, const char* lpszText)
+	{
+		WriteLogRec(nType, (const BYTE*)lpszText, (int)strlen(lpszText));
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+LISBenchConfig::LISBenchConfig()
+{
+	this->bNTI = false;
+	this->nLogicalFileNum = 1;
+	this->nRecordNum = 10000;
+	this->nFramePerRecord = 16;
+	this->nMaxPRSize = 1024;
+	this->bDepthInFrame = false;
+	this->nDirection = 255;
+	this->fStep = 0.1;
+	this->fStartDepth = 1000.0;
+	this->nSeed = 1;
+
+	AddChannel("GR", "GAPI", 68);
+	AddChannel("RHOB", "G/C3", 68);
+	AddChannel("NPHI", "PU", 73);
+	AddChannel("CALI", "IN", 79);
+	AddChannel("SP", "MV", 70);
+	AddChannel("WF", "MV", 79, 4);//Kenh nhanh
+	AddChannel("ARR", "OHMM", 68, 1, 8);//Kenh mang
+}
+
+void LISBenchConfig::AddChannel(LPCTSTR lpszMnemonic, LPCTSTR lpszUnits, int nReprCode, int nNbSamples, int nItemNum)
+{
+	LISBenchChannel		chan;
+
+	chan.strMnemonic = lpszMnemonic;
+	chan.strUnits = lpszUnits;
+	chan.nReprCode = nReprCode;
+	chan.nNbSamples = nNbSamples;
+	chan.nItemNum = nItemNum;
+
+	this->chanArr.Add(chan);
+}
+
+//So byte mot frame (ca kenh DEPT neu bDepthInFrame)
+int LISBenchConfig::GetFrameSize() const
+{
+	int		nSize = (this->bDepthInFrame ? 4 : 0);
+
+	for(int i = 0; i<this->chanArr.GetSize(); i++)
+	{
+		const LISBenchChannel&	chan = this->chanArr[i];
+		nSize += CLisBench::GetReprSize(chan.nReprCode)*chan.nNbSamples*chan.nItemNum;
+	}
+
+	return nSize;
+}
+
+CLisBench::CLisBench()
+{
+	this->nReprValueNum = LIS_BENCH_REPRVALUENUM;
+}
+
+///////////////////////////////////////////////////////////
+// Tao file LIS/NTI tong hop. Moi Logical File: File Header, CONS,
+// DFSR, config.nRecordNum Data Record, File Trailer, Comment. Gia tri
+// cac kenh la byte ngau nhien, do sau tang (DOWN) hoac giam (UP) fStep
+// moi frame.
+///////////////////////////////////////////////////////////
+bool CLisBench::GenerateFile(LPCTSTR lpszFile, const LISBenchConfig& config)
+{
+	for(int i = 0; i<config.chanArr.GetSize(); i++)
+		if(GetReprSize(config.chanArr[i].nReprCode) == 0)
+			return false;
+
+	FILE*	hFile = fopen(lpszFile, "wb");
+	if(hFile == NULL)
+		return false;
+
+	LISBenchWriter	writer(hFile, config);
+	int				nFrameSize = config.GetFrameSize();
+	DWORD			nState = (config.nSeed != 0 ? config.nSeed : 1);
+	BYTE			val[4];
+
+	//DFSR
+	CArray<BYTE>	dfsr;
+
+	val[0] = 0;
+	AddBenchEntry(dfsr, 1, 66, val, 1);//Data Record Type
+	val[0] = (BYTE)(nFrameSize >> 8);
+	val[1] = (BYTE)nFrameSize;
+	AddBenchEntry(dfsr, 3, 79, val, 2);//Frame Size
+	val[0] = (BYTE)config.nDirection;
+	AddBenchEntry(dfsr, 4, 66, val, 1);
+	EncodeBench68(config.fStep, val);
+	AddBenchEntry(dfsr, 8, 68, val, 4);//Frame Spacing
+	AddBenchEntry(dfsr, 9, 65, (const BYTE*)"M   ", 4);
+	if(!config.bDepthInFrame)
+	{
+		val[0] = 1;
+		AddBenchEntry(dfsr, 13, 66, val, 1);//Depth Recording Mode
+		AddBenchEntry(dfsr, 14, 65, (const BYTE*)"M   ", 4);
+		val[0] = 68;
+		AddBenchEntry(dfsr, 15, 66, val, 1);
+	}
+	val[0] = 0;
+	AddBenchEntry(dfsr, 0, 66, val, 1);//Terminator
+
+	if(config.bDepthInFrame)
+	{
+		LISBenchChannel		chan;
+
+		chan.strMnemonic = "DEPT";
+		chan.strUnits = "M";
+		chan.nReprCode = 68;
+		chan.nNbSamples = 1;
+		chan.nItemNum = 1;
+		AddBenchDatum(dfsr, chan);
+	}
+	for(int i = 0; i<config.chanArr.GetSize(); i++)
+		AddBenchDatum(dfsr, config.chanArr[i]);
+
+	//Data Record
+	int		nDepthSize = (config.bDepthInFrame ? 0 : 4);
+	int		nRecSize = nDepthSize + nFrameSize*config.nFramePerRecord;
+	BYTE*	pRec = new BYTE[nRecSize];
+	double	fSign = (config.nDirection == 1 ? -1.0 : 1.0);
+
+	for(int nLF = 0; nLF<config.nLogicalFileNum && writer.bOK; nLF++)
+	{
+		BYTE	cons[16] = { 0x49, 0x41, 0x04, 0x00, 'C', 'O', 'N', 'S', 'U', 'N', 'I', 'T', 'C', 'O', 'N', 'S' };
+
+		writer.WriteLogRec(128, "FILEHEADER");
+		writer.WriteLogRec(34, cons, sizeof(cons));
+		writer.WriteLogRec(64, dfsr.GetData(), (int)dfsr.GetSize());
+
+		double	fDepth = config.fStartDepth;
+
+		for(int r = 0; r<config.nRecordNum && writer.bOK; r++)
+		{
+			if(!config.bDepthInFrame)
+				EncodeBench68(fDepth, pRec);
+
+			FillRandom(pRec + nDepthSize, nRecSize - nDepthSize, nState);
+
+			if(config.bDepthInFrame)
+				for(int f = 0; f<config.nFramePerRecord; f++)
+					EncodeBench68(fDepth + fSign*f*config.fStep, pRec + f*nFrameSize);
+
+			writer.WriteLogRec(0, pRec, nRecSize);
+			fDepth += fSign*config.nFramePerRecord*config.fStep;
+		}
+
+		writer.WriteLogRec(129, "FILETRAILER");
+		writer.WriteLogRec(232, "comment");
+	}
+
+	delete[] pRec;
+
+	bool	bOK = writer.bOK;
+
+	if(fclose(hFile) != 0)
+		bOK = false;
+
+	return bOK;
+}
+
+void CLisBench::AddResult(LPCTSTR lpszName, double fSeconds, double fBytes, double fFrames)
+{
+	LISBenchResult	result;
+
+	result.strName = lpszName;
+	result.fSeconds = fSeconds;
+	result.fBytes = fBytes;
+	result.fFrames = fFrames;
+
+	this->resultArr.Add(result);
+}
+
+///////////////////////////////////////////////////////////
+// Tao file theo config va chay tat ca cac phep do. File DAT tao ra
+// trong luc do duoc xoa; file lpszFile duoc giu lai.
+///////////////////////////////////////////////////////////
+bool CLisBench::Run(LPCTSTR lpszFile, CProgressCtrl& progress)
+{
+	this->resultArr.RemoveAll();
+
+	double	fTime = GetTime();
+
+	if(!GenerateFile(lpszFile, this->config))
+		return false;
+
+	fTime = GetTime() - fTime;
+
+	FILE*	hFile = fopen(lpszFile, "rb");
+	if(hFile == NULL)
+		return false;
+
+	fseek(hFile, 0L, SEEK_END);
+	double	fFileSize = (double)ftell(hFile);
+	fclose(hFile);
+
+	AddResult("GenerateFile", fTime, fFileSize, this->config.GetFrameNum());
+
+	BenchLISFileClass(lpszFile, fFileSize);
+	BenchCLisFile(lpszFile, progress, fFileSize);
+	BenchReprCode();
+	BenchReadCode();
+
+	return true;
+}
+
+void CLisBench::BenchLISFileClass(LPCTSTR lpszFile, double fFileSize)
+{
+	LISFileClass	lisFile;
+	double			fFrameNum = this->config.GetFrameNum();
+
+	lisFile.strFileName = lpszFile;
+	lisFile.strDATPrefix = "Bench_";
+
+	double	fTime = GetTime();
+
+	lisFile.Parse();
+	AddResult("LISFileClass::Parse", GetTime() - fTime, fFileSize, fFrameNum);
+
+	double	fParseTime = 0;
+	double	fCreateTime = 0;
+
+	for(int i = 0; i<lisFile.nLogicalFileNum; i++)
+	{
+		fTime = GetTime();
+		lisFile.ParseLogicalFile(i);
+		fParseTime += GetTime() - fTime;
+
+		fTime = GetTime();
+		lisFile.CreateDATFiles();
+		fCreateTime += GetTime() - fTime;
+
+		for(int j = 0; j<lisFile.DATASETArr.GetCount(); j++)
+			remove(lisFile.DATASETArr[j].strDATFileName);
+	}
+
+	AddResult("LISFileClass::ParseLogicalFile", fParseTime, fFileSize, fFrameNum);
+	AddResult("LISFileClass::CreateDATFiles", fCreateTime, fFileSize, fFrameNum);
+}
+
+///////////////////////////////////////////////////////////
+// Giai ma nReprValueNum gia tri ngau nhien cua moi ma bang
+// LISMisc::ReadReprCode
+///////////////////////////////////////////////////////////
+void CLisBench::BenchReprCode(void)
+{
+	static const int	nCodeArr[] = { 49, 50, 56, 66, 68, 70, 73, 79 };
+
+	DWORD		nState = 1;
+	int			nValueNum = (this->nReprValueNum > 0 ? this->nReprValueNum : 1);
+	BYTE*		pBuf = new BYTE[nValueNum*4];
+
+	for(int c = 0; c<sizeof(nCodeArr)/sizeof(nCodeArr[0]); c++)
+	{
+		int		nCode = nCodeArr[c];
+		int		nSize = GetReprSize(nCode);
+		double	fSum = 0;
+		CString	str;
+
+		FillRandom(pBuf, nValueNum*nSize, nState);
+
+		ReprCodeReturn	ret;
+		int				nRealSize;
+		double			fTime = GetTime();
+
+		for(int i = 0; i<nValueNum; i++)
+		{
+			LISMisc::ReadReprCode(pBuf + i*nSize, nSize, nCode, ret, nRealSize);
+			fSum += (ret.nType == 2 ? ret.fValue : ret.nValue);
+		}
+
+		str.Format("LISMisc::ReadReprCode %d", nCode);
+		AddResult(str, GetTime() - fTime, (double)nValueNum*nSize, nValueNum);
+
+		fSink = fSum;
+	}
+
+	delete[] pBuf;
+}
+
+//Bang ket qua: ten, thoi gian, MB/s, frames/s
+CString CLisBench::GetReport() const
+{
+	CString		strReport;
+	CString		str;
+
+	str.Format("%-36s %10s %10s %14s\r\n", "Benchmark", "Seconds", "MB/s", "Frames/s");
+	strReport += str;
+
+	for(int i = 0; i<this->resultArr.GetSize(); i++)
+	{
+		const LISBenchResult&	result = this->resultArr[i];
+
+		str.Format("%-36s %10.4f %10.2f %14.0f\r\n", (LPCTSTR)result.strName, result.fSeconds,
+			result.GetMBPerSec(), result.GetFramesPerSec());
+		strReport += str;
+	}
+
+	return strReport;
+}
@@ -0,0 +1,95 @@
+// LisBench.h: interface for the CLisBench class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#define		LIS_BENCH_REPRVALUENUM		(1024*1024)//So gia tri moi ma trong benchmark ReadReprCode/ReadCode
+
+//Mot kenh cua file tong hop
+class LISBenchChannel
+{
+public:
+	CString	strMnemonic;
+	CString	strUnits;
+	int		nReprCode;
+	int		nNbSamples;//> 1: kenh nhanh
+	int		nItemNum;//So gia tri moi sample (> 1: kenh mang)
+};
+
+//////////////////////////////////////////////////////////////////////
+// Cau hinh file LIS/NTI tong hop: so Logical File, so Data Record,
+// so frame moi record, kich thuoc PR toi da (LR dai hon duoc chia thanh
+// nhieu PR), che do do sau, chieu do va danh sach kenh.
+//////////////////////////////////////////////////////////////////////
+class LISBenchConfig
+{
+public:
+	bool	bNTI;//false: LIS co blank record truoc moi PR
+	int		nLogicalFileNum;
+	int		nRecordNum;//So Data Record moi Logical File
+	int		nFramePerRecord;
+	int		nMaxPRSize;
+	bool	bDepthInFrame;//true: do sau la kenh DEPT trong frame (Depth Recording Mode 0)
+	int		nDirection;//1: UP, 255: DOWN
+	double	fStep;//in meter
+	double	fStartDepth;//in meter
+	DWORD	nSeed;//Gia tri ngau nhien cua cac kenh
+	CArray<LISBenchChannel>	chanArr;
+public:
+	LISBenchConfig();
+
+	void	AddChannel(LPCTSTR lpszMnemonic, LPCTSTR lpszUnits, int nReprCode, int nNbSamples = 1, int nItemNum = 1);
+	int		GetFrameSize() const;
+	double	GetFrameNum() const			{ return (double)this->nLogicalFileNum*this->nRecordNum*this->nFramePerRecord; }
+};
+
+//Ket qua mot phep do
+class LISBenchResult
+{
+public:
+	CString	strName;
+	double	fSeconds;
+	double	fBytes;//So byte da xu ly
+	double	fFrames;//So frame (hoac so gia tri) da xu ly
+public:
+	double	GetMBPerSec() const			{ return (this->fSeconds > 0 ? this->fBytes/(1024.0*1024.0)/this->fSeconds : 0); }
+	double	GetFramesPerSec() const		{ return (this->fSeconds > 0 ? this->fFrames/this->fSeconds : 0); }
+};
+
+//////////////////////////////////////////////////////////////////////
+// Benchmark doc file: tao file LIS/NTI tong hop theo config roi do
+// thoi gian cac buoc chinh cua LISFileClass (Parse, ParseLogicalFile,
+// CreateDATFiles), CLisFile (OpenLisFile, GetAllData, WriteToDatFile)
+// va giai ma ma (LISMisc::ReadReprCode, CLisFile::ReadCode). Ket qua
+// tinh theo MB/s va frames/s (gia tri/s voi benchmark giai ma ma).
+// Khong co chuong trinh chay rieng: ung dung goi Run() voi mot
+// CProgressCtrl da tao roi hien thi GetReport().
+// Cac phep do CLisFile nam trong LisBenchCLisFile.cpp (LisFile.h va
+// LISFileClass.h khong the cung include trong mot file .cpp).
+//////////////////////////////////////////////////////////////////////
+class CLisBench
+{
+public:
+	LISBenchConfig			config;
+	CArray<LISBenchResult>	resultArr;
+	int						nReprValueNum;
+public:
+	CLisBench();
+
+	static bool	GenerateFile(LPCTSTR lpszFile, const LISBenchConfig& config);
+	bool	Run(LPCTSTR lpszFile, CProgressCtrl& progress);
+	CString	GetReport() const;
+
+	static double	GetTime();//giay
+	static void		FillRandom(BYTE* pDst, int nSize, DWORD& nState);
+	static int		GetReprSize(int nReprCode);//0: ma khong ho tro
+protected:
+	void	AddResult(LPCTSTR lpszName, double fSeconds, double fBytes, double fFrames);
+	void	BenchLISFileClass(LPCTSTR lpszFile, double fFileSize);
+	void	BenchCLisFile(LPCTSTR lpszFile, CProgressCtrl& progress, double fFileSize);
+	void	BenchReprCode(void);//LISMisc::ReadReprCode
+	void	BenchReadCode(void);//CLisFile::ReadCode
+
+	static volatile double	fSink;//Giu ket qua giai ma de trinh bien dich khong bo vong lap
+};
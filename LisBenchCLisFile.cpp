@@ -0,0 +1,79 @@
+// LisBenchCLisFile.cpp: cac phep do CLisFile cua CLisBench.
+// Tach khoi LisBench.cpp vi LisFile.h va LISFileClass.h dinh nghia
+// FILE_TYPE_LIS/FILE_TYPE_NTI voi gia tri khac nhau.
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisFile.h"
+#include "LisBench.h"
+
+//CLisFile chi doc Logical File dau tien: so byte/frame tinh tren cac Data Record cua no
+void CLisBench::BenchCLisFile(LPCTSTR lpszFile, CProgressCtrl& progress, double fFileSize)
+{
+	CLisFile	lisFile;
+
+	double	fTime = GetTime();
+
+	lisFile.OpenLisFile(lpszFile, progress);
+	fTime = GetTime() - fTime;
+
+	double	fDataBytes = 0;
+	double	fDataFrames = 0;
+
+	for(int r = lisFile.nStartDataRec; r>=0 && r<=lisFile.nEndDataRec; r++)
+	{
+		if(lisFile.lisRecordArr[r]->nType != 0)
+			continue;
+		fDataBytes += lisFile.lisRecordArr[r]->lLen;
+		fDataFrames += lisFile.GetFrameNum(r);
+	}
+
+	AddResult("CLisFile::OpenLisFile", fTime, fFileSize, fDataFrames);
+
+	fTime = GetTime();
+	for(int r = lisFile.nStartDataRec; r>=0 && r<=lisFile.nEndDataRec; r++)
+		if(lisFile.lisRecordArr[r]->nType == 0)
+			lisFile.GetAllData(r);
+	AddResult("CLisFile::GetAllData", GetTime() - fTime, fDataBytes, fDataFrames);
+
+	//Toan bo khoang do sau
+	fTime = GetTime();
+	lisFile.WriteToDatFile(-1e9f, 1e9f, NULL);
+	AddResult("CLisFile::WriteToDatFile", GetTime() - fTime, fDataBytes, fDataFrames);
+
+	remove(lisFile.m_strDatFileName);
+}
+
+//Giai ma nReprValueNum gia tri ngau nhien cua moi ma bang CLisFile::ReadCode,
+//cung du lieu voi BenchReprCode
+void CLisBench::BenchReadCode(void)
+{
+	static const int	nCodeArr[] = { 50, 56, 66, 68, 70, 73, 79 };//CLisFile::ReadCode khong ho tro ma 49
+
+	CLisFile	lisFile;
+	DWORD		nState = 1;
+	int			nValueNum = (this->nReprValueNum > 0 ? this->nReprValueNum : 1);
+	BYTE*		pBuf = new BYTE[nValueNum*4];
+
+	for(int c = 0; c<sizeof(nCodeArr)/sizeof(nCodeArr[0]); c++)
+	{
+		int		nCode = nCodeArr[c];
+		int		nSize = GetReprSize(nCode);
+		double	fSum = 0;
+		CString	str;
+
+		FillRandom(pBuf, nValueNum*nSize, nState);
+
+		double	fTime = GetTime();
+
+		for(int i = 0; i<nValueNum; i++)
+			fSum += lisFile.ReadCode(pBuf + i*nSize, (BYTE)nCode, (BYTE)nSize);
+
+		str.Format("CLisFile::ReadCode %d", nCode);
+		AddResult(str, GetTime() - fTime, (double)nValueNum*nSize, nValueNum);
+
+		fSink = fSum;
+	}
+
+	delete[] pBuf;
+}
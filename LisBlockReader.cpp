@@ -0,0 +1,124 @@
+// LisBlockReader.cpp: implementation of the CLisBlockReader class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisBlockReader.h"
+#include "LisPerfStats.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisBlockReader::CLisBlockReader()
+{
+	this->hFile = NULL;
+	this->lFileSize = 0;
+	this->pMap = NULL;
+
+	this->pBlock = NULL;
+	this->nBlockSize = 0;
+	this->lBlockStart = 0;
+	this->nBlockLen = 0;
+
+	this->lPos = 0;
+	this->pPerfStats = NULL;
+}
+
+CLisBlockReader::~CLisBlockReader()
+{
+	Detach();
+}
+
+void CLisBlockReader::Attach(FILE* hFile, __int64 lFileSize, int nBlockSize)
+{
+	Detach();
+
+	this->hFile = hFile;
+	this->lFileSize = lFileSize;
+	this->nBlockSize = nBlockSize;
+	this->pBlock = new BYTE[nBlockSize];
+	this->lBlockStart = 0;
+	this->nBlockLen = 0;
+	this->lPos = 0;
+}
+
+void CLisBlockReader::AttachMapped(const CLisMappedFile* pMap)
+{
+	Detach();
+
+	this->pMap = pMap;
+	this->lFileSize = pMap->lLength;
+	this->lPos = 0;
+}
+
+void CLisBlockReader::Detach()
+{
+	if(this->pBlock != NULL)
+	{
+		delete[] this->pBlock;
+		this->pBlock = NULL;
+	}
+	this->hFile = NULL;
+	this->pMap = NULL;
+	this->nBlockLen = 0;
+}
+
+bool CLisBlockReader::FillBlock(__int64 lAddr)
+{
+	this->lBlockStart = lAddr;
+	this->nBlockLen = 0;
+
+	if(lAddr < 0 || lAddr >= this->lFileSize)
+		return false;
+
+	_fseeki64(this->hFile, lAddr, SEEK_SET);
+	this->nBlockLen = (int)fread(this->pBlock, sizeof(BYTE), this->nBlockSize, this->hFile);
+
+	if(this->pPerfStats != NULL)
+	{
+		this->pPerfStats->AddSeek();
+		this->pPerfStats->AddRead(this->nBlockLen);
+	}
+
+	return (this->nBlockLen > 0);
+}
+
+//Doc nCount byte tai vi tri hien tai. Phan nam ngoai file duoc dien 0.
+int CLisBlockReader::Read(BYTE* pDst, int nCount)
+{
+	int		nDone = 0;
+
+	if(this->pMap != NULL)
+	{
+		nDone = this->pMap->Read((long)this->lPos, pDst, nCount);//Vung anh xa < 2 GB
+		this->lPos += nCount;
+		return nDone;
+	}
+
+	while(nDone < nCount)
+	{
+		if(this->lPos < this->lBlockStart || this->lPos >= this->lBlockStart + this->nBlockLen)
+		{
+			if(!FillBlock(this->lPos))
+				break;
+		}
+
+		int		nOffset = (int)(this->lPos - this->lBlockStart);
+		int		nAvail = this->nBlockLen - nOffset;
+		int		nCopy = nCount - nDone;
+		if(nCopy > nAvail) nCopy = nAvail;
+
+		memcpy(pDst + nDone, this->pBlock + nOffset, nCopy);
+		nDone += nCopy;
+		this->lPos += nCopy;
+	}
+
+	if(nDone < nCount)
+	{
+		memset(pDst + nDone, 0, nCount - nDone);
+		this->lPos += nCount - nDone;
+	}
+
+	return nDone;
+}
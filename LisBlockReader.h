@@ -0,0 +1,48 @@
+// LisBlockReader.h: interface for the CLisBlockReader class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LisMappedFile.h"
+
+#define		LIS_READER_BLOCKSIZE	(1024*1024)
+
+//////////////////////////////////////////////////////////////////////
+// Doc tuan tu mot file LIS/NTI theo tung khoi lon (Sequential block reader)
+// Cac lan doc header nho (4/6/12 byte) duoc lay tu bo dem, khong
+// phai fseek/fread cho moi header.
+// Neu file da duoc anh xa (CLisMappedFile), du lieu duoc lay truc tiep
+// tu vung anh xa.
+//////////////////////////////////////////////////////////////////////
+class CLisBlockReader
+{
+public:
+	FILE*		hFile;
+	__int64		lFileSize;		//64-bit: file > 2 GB (_fseeki64)
+	const CLisMappedFile*	pMap;
+
+	BYTE*		pBlock;
+	int			nBlockSize;
+	__int64		lBlockStart;	//Vi tri trong file cua pBlock[0]
+	int			nBlockLen;		//So byte hop le trong pBlock
+
+	__int64		lPos;			//Vi tri doc hien tai
+
+	LISPerfStats*	pPerfStats;	//!= NULL: dem fseek/fread cua FillBlock
+public:
+	CLisBlockReader();
+	~CLisBlockReader();
+
+	void	Attach(FILE* hFile, __int64 lFileSize, int nBlockSize = LIS_READER_BLOCKSIZE);
+	void	AttachMapped(const CLisMappedFile* pMap);
+	void	Detach();
+
+	int		Read(BYTE* pDst, int nCount);
+	void	Seek(__int64 lAddr)	{ lPos = lAddr; }
+	void	Skip(long lCount)	{ lPos += lCount; }
+	__int64	Tell()				{ return lPos; }
+
+private:
+	bool	FillBlock(__int64 lAddr);
+};
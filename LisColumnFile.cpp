@@ -0,0 +1,336 @@
+// LisColumnFile.cpp: implementation of the CLisColumnFile class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisColumnFile.h"
+
+static __int64 AlignColumnPos(__int64 lPos)
+{
+	return (lPos + LIS_COLUMN_ALIGN - 1) & ~(__int64)(LIS_COLUMN_ALIGN - 1);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisColumnFile::CLisColumnFile()
+{
+	this->hFile = NULL;
+	this->pColBuf = NULL;
+	this->nColBufSize = 0;
+	this->bWriteError = false;
+	memset(&this->header, 0, sizeof(this->header));
+}
+
+CLisColumnFile::~CLisColumnFile()
+{
+	Close();
+}
+
+//Tra ve false neu fclose hoac mot lan WriteRows that bai
+bool CLisColumnFile::Close()
+{
+	bool	bOK = !this->bWriteError;
+
+	if(this->hFile != NULL)
+	{
+		if(fclose(this->hFile) != 0)
+			bOK = false;
+		this->hFile = NULL;
+	}
+	if(this->pColBuf != NULL)
+	{
+		delete[] this->pColBuf;
+		this->pColBuf = NULL;
+	}
+	this->nColBufSize = 0;
+	this->rowWrittenArr.RemoveAll();
+	this->bWriteError = false;
+
+	return bOK;
+}
+
+//Ten kenh/don vi: toi da 7 ky tu, ket thuc bang 0
+void CLisColumnFile::SetName(char szDst[8], LPCTSTR lpszSrc)
+{
+	memset(szDst, 0, 8);
+	strncpy(szDst, lpszSrc, 7);
+}
+
+float* CLisColumnFile::GetColBuf(int nSize)
+{
+	if(nSize > this->nColBufSize)
+	{
+		delete[] this->pColBuf;
+		this->pColBuf = new float[nSize];
+		this->nColBufSize = nSize;
+	}
+	return this->pColBuf;
+}
+
+///////////////////////////////////////////////////////////
+// Tinh vi tri cac cot (cot do sau roi cac kenh cua tung Dataset,
+// can le LIS_COLUMN_ALIGN) va ghi header + cac bang vao dau file.
+///////////////////////////////////////////////////////////
+bool CLisColumnFile::Create(LPCTSTR lpszFile)
+{
+	if(this->hFile != NULL)
+		fclose(this->hFile);
+
+	this->hFile = fopen(lpszFile, "wb");
+	this->bWriteError = false;
+	if(this->hFile == NULL)
+		return false;
+
+	int		nDatasetNum = (int)this->datasetArr.GetSize();
+	int		nChannelNum = (int)this->channelArr.GetSize();
+
+	this->header.nMagic = LIS_COLUMN_MAGIC;
+	this->header.nVersion = LIS_COLUMN_VERSION;
+	this->header.nDatasetNum = nDatasetNum;
+	this->header.nChannelNum = nChannelNum;
+	this->header.nAlign = LIS_COLUMN_ALIGN;
+	this->header.nReserved = 0;
+
+	__int64	lPos = (__int64)(sizeof(LISColumnFileHeader) + nDatasetNum * sizeof(LISColumnDataset) +
+						nChannelNum * sizeof(LISColumnChannel));
+
+	for(int i = 0; i<nDatasetNum; i++)
+	{
+		LISColumnDataset&	dataset = this->datasetArr[i];
+
+		lPos = AlignColumnPos(lPos);
+		dataset.lDepthPos = lPos;
+		lPos += (__int64)dataset.nRowNum * sizeof(float);
+
+		for(int j = 0; j<nChannelNum; j++)
+		{
+			LISColumnChannel&	chan = this->channelArr[j];
+
+			if(chan.nDatasetIdx != i)
+				continue;
+
+			lPos = AlignColumnPos(lPos);
+			chan.lDataPos = lPos;
+			lPos += (__int64)dataset.nRowNum * chan.nDataItemNum * sizeof(float);
+		}
+	}
+
+	bool	bOK = (fwrite(&this->header, sizeof(this->header), 1, this->hFile) == 1);
+
+	if(bOK && nDatasetNum > 0)
+		bOK = ((int)fwrite(this->datasetArr.GetData(), sizeof(LISColumnDataset), nDatasetNum, this->hFile) == nDatasetNum);
+	if(bOK && nChannelNum > 0)
+		bOK = ((int)fwrite(this->channelArr.GetData(), sizeof(LISColumnChannel), nChannelNum, this->hFile) == nChannelNum);
+
+	this->rowWrittenArr.SetSize(nDatasetNum);
+	for(int i = 0; i<nDatasetNum; i++)
+		this->rowWrittenArr[i] = 0;
+
+	if(!bOK)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+// Ghi nRowNum dong tiep theo cua Dataset nDataset (dinh dang dong
+// cua file DAT: do sau + nTotalItemNum gia tri): tach thanh tung cot
+// va ghi vao dung vi tri cua cot do trong file. Tra ve false neu
+// fseek/fwrite that bai (Close cung tra ve false).
+///////////////////////////////////////////////////////////
+bool CLisColumnFile::WriteRows(int nDataset, const float* pRows, int nRowNum)
+{
+	if(this->hFile == NULL || nDataset < 0 || nDataset >= this->datasetArr.GetSize())
+		return false;
+
+	const LISColumnDataset&	dataset = this->datasetArr[nDataset];
+	int		nRowSize = dataset.nTotalItemNum + 1;
+	int		nRowStart = this->rowWrittenArr[nDataset];
+
+	if(nRowNum > dataset.nRowNum - nRowStart)
+		nRowNum = dataset.nRowNum - nRowStart;
+	if(nRowNum <= 0)
+		return true;
+
+	//Cot do sau
+	float*	pDst = GetColBuf(nRowNum);
+	const float*	pSrc = pRows;
+
+	for(int r = 0; r<nRowNum; r++, pSrc += nRowSize)
+		pDst[r] = pSrc[0];
+
+	bool	bOK = (_fseeki64(this->hFile, dataset.lDepthPos + (__int64)nRowStart * sizeof(float), SEEK_SET) == 0);
+
+	if(bOK)
+		bOK = ((int)fwrite(pDst, sizeof(float), nRowNum, this->hFile) == nRowNum);
+
+	//Cac kenh cua Dataset
+	for(int j = 0; bOK && j<this->channelArr.GetSize(); j++)
+	{
+		const LISColumnChannel&	chan = this->channelArr[j];
+		int		nItem = chan.nDataItemNum;
+
+		if(chan.nDatasetIdx != nDataset || nItem <= 0)
+			continue;
+
+		pDst = GetColBuf(nRowNum * nItem);
+		pSrc = pRows + 1 + chan.nPosInDataset;
+
+		if(nItem == 1)
+		{
+			for(int r = 0; r<nRowNum; r++, pSrc += nRowSize)
+				pDst[r] = pSrc[0];
+		}
+		else
+		{
+			for(int r = 0; r<nRowNum; r++, pSrc += nRowSize)
+				memcpy(pDst + r * nItem, pSrc, nItem * sizeof(float));
+		}
+
+		bOK = (_fseeki64(this->hFile, chan.lDataPos + (__int64)nRowStart * nItem * sizeof(float), SEEK_SET) == 0);
+		if(bOK)
+			bOK = ((int)fwrite(pDst, sizeof(float), nRowNum * nItem, this->hFile) == nRowNum * nItem);
+	}
+
+	if(!bOK)
+	{
+		this->bWriteError = true;
+		return false;
+	}
+
+	this->rowWrittenArr[nDataset] = nRowStart + nRowNum;
+	return true;
+}
+
+//Chuyen file DAT (dinh dang dong) cua Dataset nDataset sang cac cot
+bool CLisColumnFile::WriteRowFile(int nDataset, LPCTSTR lpszRowFile, int nBufSize)
+{
+	if(this->hFile == NULL || nDataset < 0 || nDataset >= this->datasetArr.GetSize())
+		return false;
+
+	FILE*	hRowFile = fopen(lpszRowFile, "rb");
+	if(hRowFile == NULL)
+		return false;
+
+	int		nRowSize = this->datasetArr[nDataset].nTotalItemNum + 1;
+	int		nChunk = nBufSize / (nRowSize * (int)sizeof(float));
+
+	if(nChunk < 1)
+		nChunk = 1;
+
+	float*	pRows = new float[nChunk * nRowSize];
+	int		nRead;
+	bool	bOK = true;
+
+	while(bOK && (nRead = (int)fread(pRows, nRowSize * sizeof(float), nChunk, hRowFile)) > 0)
+		bOK = WriteRows(nDataset, pRows, nRead);
+
+	delete[] pRows;
+	fclose(hRowFile);
+
+	return (bOK && this->rowWrittenArr[nDataset] == this->datasetArr[nDataset].nRowNum);
+}
+
+///////////////////////////////////////////////////////////
+// Mo file cot de doc: chi doc header va cac bang Dataset/kenh,
+// du lieu doc theo tung cot (ReadDepth/ReadChannel) khi can.
+///////////////////////////////////////////////////////////
+bool CLisColumnFile::Open(LPCTSTR lpszFile)
+{
+	Close();
+	this->datasetArr.RemoveAll();
+	this->channelArr.RemoveAll();
+
+	this->hFile = fopen(lpszFile, "rb");
+	if(this->hFile == NULL)
+		return false;
+
+	bool	bOK = (fread(&this->header, sizeof(this->header), 1, this->hFile) == 1);
+
+	if(bOK)
+		bOK = (this->header.nMagic == LIS_COLUMN_MAGIC &&
+			this->header.nVersion == LIS_COLUMN_VERSION &&
+			this->header.nDatasetNum >= 0 && this->header.nChannelNum >= 0);
+
+	if(bOK)
+	{
+		this->datasetArr.SetSize(this->header.nDatasetNum);
+		this->channelArr.SetSize(this->header.nChannelNum);
+
+		if(this->header.nDatasetNum > 0)
+			bOK = ((int)fread(this->datasetArr.GetData(), sizeof(LISColumnDataset),
+					this->header.nDatasetNum, this->hFile) == this->header.nDatasetNum);
+		if(bOK && this->header.nChannelNum > 0)
+			bOK = ((int)fread(this->channelArr.GetData(), sizeof(LISColumnChannel),
+					this->header.nChannelNum, this->hFile) == this->header.nChannelNum);
+	}
+
+	for(int j = 0; bOK && j<this->channelArr.GetSize(); j++)
+	{
+		int		nDataset = this->channelArr[j].nDatasetIdx;
+		bOK = (nDataset >= 0 && nDataset < this->datasetArr.GetSize());
+	}
+
+	if(!bOK)
+	{
+		Close();
+		this->datasetArr.RemoveAll();
+		this->channelArr.RemoveAll();
+		return false;
+	}
+
+	return true;
+}
+
+//Chi so kenh co ten lpszMnemonic (khong phan biet hoa thuong), -1 neu khong co
+int CLisColumnFile::FindChannel(LPCTSTR lpszMnemonic) const
+{
+	for(int j = 0; j<this->channelArr.GetSize(); j++)
+	{
+		CString		str = this->channelArr[j].szMnemonic;
+
+		str.TrimRight();
+		if(str.CompareNoCase(lpszMnemonic) == 0)
+			return j;
+	}
+
+	return -1;
+}
+
+//nCount: 64-bit de khong tran khi nhan nRowNum * nDataItemNum
+bool CLisColumnFile::ReadAt(__int64 lPos, float* pDst, __int64 nCount)
+{
+	if(this->hFile == NULL)
+		return false;
+	if(nCount <= 0)
+		return true;
+	if(_fseeki64(this->hFile, lPos, SEEK_SET) != 0)
+		return false;
+
+	return ((__int64)fread(pDst, sizeof(float), (size_t)nCount, this->hFile) == nCount);
+}
+
+//Cot do sau cua Dataset nDataset (nRowNum float)
+bool CLisColumnFile::ReadDepth(int nDataset, float* pDst)
+{
+	if(nDataset < 0 || nDataset >= this->datasetArr.GetSize())
+		return false;
+
+	const LISColumnDataset&	dataset = this->datasetArr[nDataset];
+	return ReadAt(dataset.lDepthPos, pDst, dataset.nRowNum);
+}
+
+//Du lieu cua kenh nChannel (nRowNum * nDataItemNum float cua Dataset chua kenh)
+bool CLisColumnFile::ReadChannel(int nChannel, float* pDst)
+{
+	if(nChannel < 0 || nChannel >= this->channelArr.GetSize())
+		return false;
+
+	const LISColumnChannel&	chan = this->channelArr[nChannel];
+	return ReadAt(chan.lDataPos, pDst, (__int64)this->datasetArr[chan.nDatasetIdx].nRowNum * chan.nDataItemNum);
+}
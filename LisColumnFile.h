@@ -0,0 +1,92 @@
+// LisColumnFile.h: interface for the CLisColumnFile class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#define		LIS_COLUMN_MAGIC		0x4C4F434C//"LCOL"
+#define		LIS_COLUMN_VERSION		2//2: vi tri cot 64-bit
+#define		LIS_COLUMN_ALIGN		64//Moi mang (cot) bat dau o vi tri chia het cho 64 byte
+#define		LIS_COLUMN_BUFSIZE		(4*1024*1024)
+
+class LISColumnFileHeader
+{
+public:
+	DWORD	nMagic;
+	int		nVersion;
+	int		nDatasetNum;
+	int		nChannelNum;
+	int		nAlign;
+	int		nReserved;
+};
+
+//Mot Dataset (cac kenh cung nNbSamples): cot do sau dung chung
+class LISColumnDataset
+{
+public:
+	int		nNbSamples;
+	int		nTotalItemNum;//So gia tri cua cac kenh trong mot dong
+	float	fStep;//in meters
+	int		nRowNum;
+	__int64	lDepthPos;//Vi tri cot do sau (nRowNum float)
+};
+
+//Mot kenh: nRowNum * nDataItemNum float lien tuc, cac item cua mot dong canh nhau
+class LISColumnChannel
+{
+public:
+	char	szMnemonic[8];
+	char	szUnits[8];
+	int		nDatasetIdx;
+	int		nIndexInDataset;
+	int		nPosInDataset;//Cot trong dong cua file DAT: 1 + nPosInDataset
+	int		nDataItemNum;
+	int		nReprCode;
+	int		nReserved;//lDataPos can le 8 byte
+	__int64	lDataPos;
+};
+
+//////////////////////////////////////////////////////////////////////
+// File du lieu dang cot (.lcol): thay cho cac file Dataset_%d.dat ghi
+// theo dong, moi kenh la mot mang lien tuc rieng, can le
+// LIS_COLUMN_ALIGN byte, cung voi cot do sau cua tung Dataset. Header,
+// bang Dataset va bang kenh nam o dau file, nen chuong trinh doc chi
+// can doc (hoac anh xa) cac kenh can dung.
+//
+// Ghi: dien datasetArr (nRowNum) va channelArr, goi Create roi
+// WriteRows theo thu tu dong cua tung Dataset (CLisDatWriter::AttachColumns).
+// Close tra ve false neu co lan ghi nao that bai ke tu Create.
+// Vi tri cac cot la 64-bit (_fseeki64): file co the lon hon 2 GB.
+//////////////////////////////////////////////////////////////////////
+class CLisColumnFile
+{
+public:
+	LISColumnFileHeader			header;
+	CArray<LISColumnDataset>	datasetArr;
+	CArray<LISColumnChannel>	channelArr;
+	FILE*						hFile;
+protected:
+	CArray<int>					rowWrittenArr;//So dong da ghi cua moi Dataset
+	bool						bWriteError;//fseek/fwrite that bai ke tu Create
+	float*						pColBuf;
+	int							nColBufSize;
+public:
+	CLisColumnFile();
+	~CLisColumnFile();
+
+	bool	Close();
+
+	bool	Create(LPCTSTR lpszFile);
+	bool	WriteRows(int nDataset, const float* pRows, int nRowNum);
+	bool	WriteRowFile(int nDataset, LPCTSTR lpszRowFile, int nBufSize = LIS_COLUMN_BUFSIZE);
+
+	bool	Open(LPCTSTR lpszFile);
+	int		FindChannel(LPCTSTR lpszMnemonic) const;
+	bool	ReadDepth(int nDataset, float* pDst);
+	bool	ReadChannel(int nChannel, float* pDst);
+
+	static void	SetName(char szDst[8], LPCTSTR lpszSrc);
+protected:
+	float*	GetColBuf(int nSize);
+	bool	ReadAt(__int64 lPos, float* pDst, __int64 nCount);
+};
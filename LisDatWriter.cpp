@@ -0,0 +1,180 @@
+// LisDatWriter.cpp: implementation of the CLisDatWriter class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisDatWriter.h"
+#include "LisColumnFile.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisDatWriter::CLisDatWriter()
+{
+	this->hFile = NULL;
+	this->pColumnFile = NULL;
+	this->nColumnDataset = 0;
+
+	this->pBuf = NULL;
+	this->nRowSize = 0;
+	this->nRowCapacity = 0;
+	this->nRowNum = 0;
+	this->bWriteError = false;
+}
+
+CLisDatWriter::~CLisDatWriter()
+{
+	Detach();
+}
+
+void CLisDatWriter::Attach(FILE* hFile, int nRowSize, int nBufSize)
+{
+	Detach();
+
+	this->hFile = hFile;
+	this->nRowSize = nRowSize;
+	this->nRowCapacity = nBufSize / (nRowSize * (int)sizeof(float));
+	if(this->nRowCapacity < 1)
+		this->nRowCapacity = 1;
+
+	this->pBuf = new float[this->nRowCapacity * nRowSize];
+	this->nRowNum = 0;
+	this->bWriteError = false;
+}
+
+//Ghi cac dong vao Dataset nDataset cua file cot da Create
+void CLisDatWriter::AttachColumns(CLisColumnFile* pColumnFile, int nDataset, int nRowSize, int nBufSize)
+{
+	Attach(NULL, nRowSize, nBufSize);
+
+	this->pColumnFile = pColumnFile;
+	this->nColumnDataset = nDataset;
+}
+
+//Ghi phan con lai trong bo dem va giai phong bo dem (khong dong file)
+void CLisDatWriter::Detach()
+{
+	if(this->pBuf != NULL)
+	{
+		Flush();
+
+		delete[] this->pBuf;
+		this->pBuf = NULL;
+	}
+	this->hFile = NULL;
+	this->pColumnFile = NULL;
+	this->nRowNum = 0;
+}
+
+bool CLisDatWriter::Flush()
+{
+	int		nCount = this->nRowNum * this->nRowSize;
+
+	if(this->nRowNum > 0 && this->pColumnFile != NULL)
+	{
+		if(!this->pColumnFile->WriteRows(this->nColumnDataset, this->pBuf, this->nRowNum))
+			this->bWriteError = true;
+	}
+	else if(this->nRowNum > 0 && this->hFile != NULL)
+	{
+		if((int)fwrite(this->pBuf, sizeof(float), nCount, this->hFile) != nCount)
+			this->bWriteError = true;
+	}
+
+	this->nRowNum = 0;
+	return !this->bWriteError;
+}
+
+//Bo dem duoc mo rong neu nCount vuot qua suc chua
+float* CLisDatWriter::AppendRows(int nCount)
+{
+	if(this->nRowNum + nCount > this->nRowCapacity)
+		Flush();
+
+	if(nCount > this->nRowCapacity)
+	{
+		delete[] this->pBuf;
+		this->nRowCapacity = nCount;
+		this->pBuf = new float[this->nRowCapacity * this->nRowSize];
+	}
+
+	float*	pRows = this->pBuf + this->nRowNum * this->nRowSize;
+
+	this->nRowNum += nCount;
+	return pRows;
+}
+
+//Dao nguoc thu tu nRowNum dong lien tiep trong pRows (pTmp: mot dong)
+static void ReverseRowBlock(float* pRows, int nRowNum, int nRowSize, float* pTmp)
+{
+	int		nRowBytes = nRowSize * (int)sizeof(float);
+
+	for(int i = 0, j = nRowNum - 1; i < j; i++, j--)
+	{
+		memcpy(pTmp, pRows + i * nRowSize, nRowBytes);
+		memcpy(pRows + i * nRowSize, pRows + j * nRowSize, nRowBytes);
+		memcpy(pRows + j * nRowSize, pTmp, nRowBytes);
+	}
+}
+
+///////////////////////////////////////////////////////////
+// Dao nguoc thu tu cac dong ngay tren file (khong can file tam): doi cho
+// tung cap khoi dong o hai dau file, tien dan vao giua. Moi khoi toi da
+// nBufSize/2 byte, nen bo nho khong phu thuoc kich thuoc file.
+///////////////////////////////////////////////////////////
+bool CLisDatWriter::ReverseRows(LPCTSTR lpszFile, int nRowSize, int nBufSize)
+{
+	FILE*	hFile = fopen(lpszFile, "r+b");
+	if(hFile == NULL)
+		return false;
+
+	int		nRowBytes = nRowSize * (int)sizeof(float);
+	int		nChunk = nBufSize / 2 / nRowBytes;
+
+	if(nChunk < 1)
+		nChunk = 1;
+
+	_fseeki64(hFile, 0, SEEK_END);
+	__int64	nFirst = 0;
+	__int64	nLast = _ftelli64(hFile) / nRowBytes;//Sau dong cuoi (file > 2 GB)
+
+	float*	pFront = new float[nChunk * nRowSize];
+	float*	pBack = new float[nChunk * nRowSize];
+	float*	pTmp = new float[nRowSize];
+	bool	bOK = true;
+
+	while(bOK && nLast - nFirst >= 2)
+	{
+		int		n = (int)((nLast - nFirst) / 2);
+		if(n > nChunk)
+			n = nChunk;
+
+		_fseeki64(hFile, nFirst * nRowBytes, SEEK_SET);
+		bOK = ((int)fread(pFront, nRowBytes, n, hFile) == n);
+		_fseeki64(hFile, (nLast - n) * nRowBytes, SEEK_SET);
+		bOK = bOK && ((int)fread(pBack, nRowBytes, n, hFile) == n);
+		if(!bOK)
+			break;
+
+		ReverseRowBlock(pFront, n, nRowSize, pTmp);
+		ReverseRowBlock(pBack, n, nRowSize, pTmp);
+
+		_fseeki64(hFile, nFirst * nRowBytes, SEEK_SET);
+		bOK = ((int)fwrite(pBack, nRowBytes, n, hFile) == n);
+		_fseeki64(hFile, (nLast - n) * nRowBytes, SEEK_SET);
+		bOK = bOK && ((int)fwrite(pFront, nRowBytes, n, hFile) == n);
+
+		nFirst += n;
+		nLast -= n;
+	}
+
+	delete[] pFront;
+	delete[] pBack;
+	delete[] pTmp;
+
+	if(fclose(hFile) != 0)
+		bOK = false;
+
+	return bOK;
+}
@@ -0,0 +1,54 @@
+// LisDatWriter.h: interface for the CLisDatWriter class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#define		LIS_WRITER_BUFSIZE		(4*1024*1024)
+
+class CLisColumnFile;
+
+//////////////////////////////////////////////////////////////////////
+// Ghi file DAT theo tung dong (do sau + du lieu cac kenh).
+// Cac dong duoc tao truc tiep trong bo dem lon (AppendRow) va chi ghi
+// xuong file khi bo dem day (Flush), thay vi fwrite cho tung gia tri.
+// AttachColumns: cac dong duoc tach thanh cot va ghi vao file cot
+// (CLisColumnFile) thay cho file DAT.
+//////////////////////////////////////////////////////////////////////
+class CLisDatWriter
+{
+public:
+	FILE*		hFile;
+	CLisColumnFile*	pColumnFile;
+	int			nColumnDataset;	//Dataset trong pColumnFile
+
+	float*		pBuf;
+	int			nRowSize;		//So float trong mot dong
+	int			nRowCapacity;	//So dong toi da trong pBuf
+	int			nRowNum;		//So dong dang cho ghi
+	bool		bWriteError;	//Mot lan Flush da ghi thieu
+public:
+	CLisDatWriter();
+	~CLisDatWriter();
+
+	void	Attach(FILE* hFile, int nRowSize, int nBufSize = LIS_WRITER_BUFSIZE);
+	void	AttachColumns(CLisColumnFile* pColumnFile, int nDataset, int nRowSize, int nBufSize = LIS_WRITER_BUFSIZE);
+	void	Detach();
+	//Tra ve false neu lan ghi nay hoac mot lan Flush truoc (ke ca
+	//Flush tu AppendRow/AppendRows) that bai
+	bool	Flush();
+
+	//Tra ve vung nho cua dong tiep theo (ghi xuong file o lan Flush sau)
+	float*	AppendRow()
+	{
+		if(nRowNum == nRowCapacity)
+			Flush();
+		return pBuf + (nRowNum++) * nRowSize;
+	}
+
+	//Tra ve vung nho lien tuc cho nCount dong tiep theo
+	float*	AppendRows(int nCount);
+
+	//Dao nguoc thu tu cac dong cua file DAT da ghi xong (dung nBufSize byte)
+	static bool	ReverseRows(LPCTSTR lpszFile, int nRowSize, int nBufSize = LIS_WRITER_BUFSIZE);
+};
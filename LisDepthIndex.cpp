@@ -0,0 +1,220 @@
+// LisDepthIndex.cpp: implementation of the CLisDepthIndex class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisDepthIndex.h"
+#include <math.h>
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisDepthIndex::CLisDepthIndex()
+{
+	this->nDirection = 1;
+	this->bSorted = true;
+	this->fStep = 0;
+}
+
+void CLisDepthIndex::RemoveAll()
+{
+	this->entryArr.RemoveAll();
+	this->nDirection = 1;
+	this->bSorted = true;
+	this->fStep = 0;
+}
+
+void CLisDepthIndex::Add(int nRec, float fDepth, int nFrameNum)
+{
+	LISDepthEntry	entry;
+
+	entry.nRec = nRec;
+	entry.nFrameNum = nFrameNum;
+	entry.fDepth = fDepth;
+
+	this->entryArr.Add(entry);
+}
+
+void CLisDepthIndex::Finish(double fStep)
+{
+	int		nCount = this->GetCount();
+
+	this->fStep = (fStep < 0) ? -fStep : fStep;
+	this->nDirection = 1;
+	this->bSorted = true;
+
+	if(nCount < 2)
+		return;
+
+	if(this->entryArr[nCount - 1].fDepth < this->entryArr[0].fDepth)
+		this->nDirection = -1;
+
+	for(int i = 1; i < nCount; i++)
+		if(this->GetKey(i) < this->GetKey(i - 1))
+		{
+			this->bSorted = false;
+			break;
+		}
+}
+
+//Khoa tang dan theo thu tu record: do sau * huong
+double CLisDepthIndex::GetKey(int idx) const
+{
+	return this->entryArr[idx].fDepth * (double)this->nDirection;
+}
+
+//Khoa cua frame cuoi cung trong record
+double CLisDepthIndex::GetEndKey(int idx) const
+{
+	int		nFrameNum = this->entryArr[idx].nFrameNum;
+
+	if(nFrameNum < 1) nFrameNum = 1;
+
+	return this->GetKey(idx) + (nFrameNum - 1) * this->fStep;
+}
+
+//Phan tu dau tien co khoa > fKey
+int CLisDepthIndex::UpperBound(double fKey) const
+{
+	int		nLo = 0;
+	int		nHi = this->GetCount();
+
+	while(nLo < nHi)
+	{
+		int		nMid = (nLo + nHi) / 2;
+
+		if(this->GetKey(nMid) <= fKey)
+			nLo = nMid + 1;
+		else
+			nHi = nMid;
+	}
+
+	return nLo;
+}
+
+bool CLisDepthIndex::FindRange(double fTop, double fBottom, int& nFirstRec, int& nLastRec) const
+{
+	int		nCount = this->GetCount();
+
+	if(nCount == 0)
+		return false;
+
+	if(fTop > fBottom)
+	{
+		double	fTemp = fTop;
+		fTop = fBottom;
+		fBottom = fTemp;
+	}
+
+	double	fKeyLo = (this->nDirection > 0) ? fTop : -fBottom;
+	double	fKeyHi = (this->nDirection > 0) ? fBottom : -fTop;
+	int		nFirst;
+	int		nLast;
+
+	if(this->bSorted)
+	{
+		nLast = this->UpperBound(fKeyHi) - 1;
+		if(nLast < 0)
+			return false;
+
+		nFirst = this->UpperBound(fKeyLo) - 1;
+		if(nFirst < 0)
+			nFirst = 0;
+
+		//Record nFirst ket thuc truoc fKeyLo
+		if(this->GetEndKey(nFirst) < fKeyLo)
+		{
+			if(nFirst == nLast)
+				return false;
+			nFirst++;
+		}
+	}
+	else
+	{
+		nFirst = -1;
+		nLast = -1;
+		for(int i = 0; i < nCount; i++)
+		{
+			if(this->GetEndKey(i) < fKeyLo || this->GetKey(i) > fKeyHi)
+				continue;
+
+			if(nFirst < 0) nFirst = i;
+			nLast = i;
+		}
+		if(nFirst < 0)
+			return false;
+	}
+
+	nFirstRec = this->entryArr[nFirst].nRec;
+	nLastRec = this->entryArr[nLast].nRec;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+// Tim sample gan do sau fDepth nhat: record chua fDepth (tim nhi phan
+// neu do sau don dieu), frame va sample tinh tu do sau dau record va
+// fStep. Do sau cua sample giong luc giai ma: do sau frame +
+// nSampleDir * nSample * fStep / nSampleNum, nen voi huong UP cac
+// sample co the nam nguoc chieu cac frame. Tra ve false neu fDepth
+// nam ngoai cac record.
+///////////////////////////////////////////////////////////
+bool CLisDepthIndex::FindFrame(double fDepth, int nSampleNum, int nSampleDir, int& nRec, int& nFrame, int& nSample) const
+{
+	int		nCount = this->GetCount();
+
+	if(nCount == 0 || this->fStep <= 0 || nSampleNum < 1)
+		return false;
+
+	double	fKey = fDepth * (double)this->nDirection;
+	double	fSampleStep = this->fStep / nSampleNum;
+	//Khoa giam theo sample: khoa = khoa frame - nSample * fSampleStep
+	bool	bBackward = (nSampleDir * this->nDirection < 0);
+	//Khoa nho nhat (so voi GetKey) va lon nhat (so voi GetEndKey) cua record
+	double	fLo = bBackward ? -(nSampleNum - 1) * fSampleStep : 0;
+	double	fHi = bBackward ? 0 : (nSampleNum - 1) * fSampleStep;
+	int		idx = -1;
+
+	if(this->bSorted)
+		idx = this->UpperBound(fKey - fLo + fSampleStep / 2) - 1;
+	else
+	{
+		for(int i = 0; i < nCount; i++)
+			if(this->GetKey(i) + fLo - fSampleStep / 2 <= fKey &&
+				fKey < this->GetEndKey(i) + fHi + fSampleStep / 2)
+			{
+				idx = i;
+				break;
+			}
+	}
+
+	if(idx < 0)
+		return false;
+
+	const LISDepthEntry&	entry = this->entryArr[idx];
+	int		nPos = (int)floor((fKey - this->GetKey(idx)) / fSampleStep + 0.5);
+
+	//nPos = nFrame * nSampleNum + nSample (bBackward: - nSample)
+	if(bBackward)
+	{
+		if(nPos < 1 - nSampleNum)
+			nPos = 1 - nSampleNum;
+		nFrame = (nPos + nSampleNum - 1) / nSampleNum;
+		nSample = nFrame * nSampleNum - nPos;
+	}
+	else
+	{
+		if(nPos < 0)
+			nPos = 0;
+		nFrame = nPos / nSampleNum;
+		nSample = nPos % nSampleNum;
+	}
+
+	if(nFrame >= entry.nFrameNum)
+		return false;
+
+	nRec = entry.nRec;
+
+	return true;
+}
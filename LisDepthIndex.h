@@ -0,0 +1,47 @@
+// LisDepthIndex.h: interface for the CLisDepthIndex class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//Mot Data Record: do sau cua frame dau tien (m) va so frame
+class LISDepthEntry
+{
+public:
+	int		nRec;//Chi so record (LR) trong file
+	int		nFrameNum;
+	float	fDepth;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Chi muc do sau -> Data Record, moi record mot phan tu theo thu tu
+// trong file. Do sau tang (DOWN) hoac giam (UP) theo thu tu record,
+// nen mot khoang do sau duoc doi ra khoang record bang tim kiem nhi
+// phan (FindRange). Neu do sau khong don dieu thi duyet tuan tu.
+//////////////////////////////////////////////////////////////////////
+class CLisDepthIndex
+{
+public:
+	CArray<LISDepthEntry>	entryArr;
+	int						nDirection;//1: do sau tang theo record, -1: giam
+	bool					bSorted;//Do sau don dieu theo nDirection
+	double					fStep;//Khoang cach giua hai frame (m, > 0)
+public:
+	CLisDepthIndex();
+
+	void	RemoveAll();
+	void	Add(int nRec, float fDepth, int nFrameNum);
+	void	Finish(double fStep);//Goi sau khi Add het cac record
+
+	int		GetCount() const	{ return (int)entryArr.GetCount(); }
+
+	//Khoang record [nFirstRec, nLastRec] co frame nam trong [fTop, fBottom]
+	bool	FindRange(double fTop, double fBottom, int& nFirstRec, int& nLastRec) const;
+	//Record, frame va sample (nSampleNum sample moi frame) gan fDepth nhat.
+	//nSampleDir: dau cua buoc do sau giua hai sample lien tiep (nhu khi giai ma)
+	bool	FindFrame(double fDepth, int nSampleNum, int nSampleDir, int& nRec, int& nFrame, int& nSample) const;
+protected:
+	double	GetKey(int idx) const;
+	double	GetEndKey(int idx) const;
+	int		UpperBound(double fKey) const;
+};
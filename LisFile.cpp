@@ -5,6 +5,9 @@
 #include "stdafx.h"
 
 #include "LisFile.h"
+#include "LisReprCode.h"
+#include "LisIndexCache.h"
+#include "LisFileType.h"
 #include <math.h>
 
 #ifdef _DEBUG
@@ -13,6 +16,44 @@ static char THIS_FILE[]=__FILE__;
 #define new DEBUG_NEW
 #endif
 
+//Cac section trong file chi muc (.cidx)
+#define		IDXTAG_INFO		1//IDXINFO_NUM so nguyen
+#define		IDXTAG_BLANK	2//LISIndexBlank
+#define		IDXTAG_REC		3//LISIndexRec
+#define		IDXTAG_NAME		4//Ten cac record, ket thuc bang 0
+
+#define		IDXINFO_FILETYPE	0
+#define		IDXINFO_DATAFSR		1
+#define		IDXINFO_CHAN		2
+#define		IDXINFO_AK73		3
+#define		IDXINFO_TOOL		4
+#define		IDXINFO_CB3			5
+#define		IDXINFO_CONS		6
+#define		IDXINFO_OUTP		7
+#define		IDXINFO_DEPTH		8//1: fDepth cua cac Data Record da duoc doc
+#define		IDXINFO_NUM			9
+
+class LISIndexBlank
+{
+public:
+	long	lPrevAddr;
+	long	lAddr;
+	long	lNextAddr;
+	long	lNextRecLen;
+	int		nNum;
+};
+
+class LISIndexRec
+{
+public:
+	int		nType;
+	long	lAddr;
+	long	lLen;
+	int		nBlockNum;
+	int		nFrameNum;
+	float	fDepth;
+};
+
 //////////////////////////////////////////////////////////////////////
 // CLisRecord Class
 //////////////////////////////////////////////////////////////////////
@@ -58,34 +99,67 @@ CBlankRecord::~CBlankRecord()
 CLisFile::CLisFile()
 {
 	bIsFileOpen=false;
+	bUseMappedFile=false;
+	bUseIndexCache=false;
+	bIndexLoaded=false;
+	lBlankScanPos=0;
+	lBlankScanAddr=0;
+	bDepthRead=false;
+	bDepthLoaded=false;
+	nDepthStartRec=0;
+	nDepthEndRec=-1;
 	
 	this->dataFormatSpec.init();
 
-	pByteData=new BYTE[150000];
-	fFileData=new float[60000];
+	pByteData=new BYTE[LIS_BYTEDATA_SIZE];
+	fFileData=new float[LIS_FILEDATA_SIZE];
+
+	nDecodeThreadNum = 0;
+	nPipelineDepth = LIS_PIPELINE_DEPTH;
+	pSlotByteData = NULL;
+	pSlotData = NULL;
+	pSlotFileData = NULL;
+	pSlotDepth = NULL;
+	pSlotRec = NULL;
+	nPipelineSlotNum = 0;
+	nPipelineItem = 0;
+	bPipelineReverse = false;
+	bShowErrors = true;
+	nDecodeErrorNum = 0;
+
+	hFile.pPerfStats = &perfStats;
+	mappedFile.pPerfStats = &perfStats;
 }
 
 CLisFile::~CLisFile()
 {
+	StopPipeline();
 	CloseLisFile();
 	delete[] pByteData;
 	delete[] fFileData;
 }
 void CLisFile::CloseLisFile()
 {
+	mappedFile.Close();
+	depthIndex.RemoveAll();
+	bIndexLoaded=false;
+	bDepthRead=false;
+	bDepthLoaded=false;
+	nDepthStartRec=0;
+	nDepthEndRec=-1;
+
+	//Blank Record va record nam trong arena: giai phong theo khoi
+	blankArr.RemoveAll();
+	blankArena.RemoveAll();
+	lisRecordArr.RemoveAll();
+	recordArena.RemoveAll();
+	nameArr.RemoveAll();
+
 	if(bIsFileOpen)
 	{
 		hFile.Close();
-		for(int i=blankArr.GetSize()-1;i>=0;i--)
-		{
-			delete blankArr[i];
-			blankArr.RemoveAt(i);
-		}
-		for(i=lisRecordArr.GetSize()-1;i>=0;i--)
-		{
-			delete lisRecordArr[i];
-			lisRecordArr.RemoveAt(i);
-		}
+
+		int		i;
 		for(i=datumArr.GetSize()-1;i>=0;i--)
 		{
 			delete datumArr[i];
@@ -123,6 +197,39 @@ void CLisFile::CloseLisFile()
 		}
 	}
 }
+
+///////////////////////////////////////////////////////////
+// Tao Blank Record/record trong arena (giai phong trong CloseLisFile).
+// Ten record duoc dung chung (InternName): chi co vai ten khac nhau.
+///////////////////////////////////////////////////////////
+CBlankRecord* CLisFile::NewBlankRecord(long lPrevAddr, long lAddr, long lNextAddr, long lNextRecLen, int nNum)
+{
+	CBlankRecord*	pBlankRec = blankArena.New();
+
+	pBlankRec->Init(lPrevAddr, lAddr, lNextAddr, lNextRecLen, nNum);
+	return pBlankRec;
+}
+
+CLisRecord* CLisFile::NewLisRecord(int nType, long lAddr, long lLen, const CString& strName)
+{
+	CLisRecord*		lisRec = recordArena.New();
+
+	lisRec->Init(nType, lAddr, lLen, this->InternName(strName));
+	return lisRec;
+}
+
+const CString& CLisFile::InternName(const CString& strName)
+{
+	for(int i = 0; i<nameArr.GetSize(); i++)
+		if(nameArr[i] == strName)
+			return nameArr[i];
+
+	if(nameArr.GetSize() >= LIS_MAX_INTERNNAME)
+		return strName;
+
+	nameArr.Add(strName);
+	return nameArr[nameArr.GetSize()-1];
+}
 ////////////////////////////////////////////////
 
 void CLisFile::ParseBlankRecord(BYTE group2[], BYTE group3[], BYTE group4[], long &lPrevAddr, long &lNextAddr, long &lNextRecLen)
@@ -138,8 +245,14 @@ void CLisFile::ParseBlankRecord(BYTE group2[], BYTE group3[], BYTE group4[], lon
 	lNextRecLen=long(group4[1])+long(group4[0])*l16x2;
 }
 
-void CLisFile::OpenNTI(CProgressCtrl& progress)//Halliburton
+///////////////////////////////////////////////////////////
+// Quet file NTI, tao bang record (lisRecordArr) va chi so cac record
+// dac biet (DFSR, CONS, OUTP...)
+///////////////////////////////////////////////////////////
+void CLisFile::ReadNTIRecordTable(CProgressCtrl& progress)
 {
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_INDEX);
+
 	CLisRecord*		pRec;
 	CBlankRecord*	pBlankRec;
 	
@@ -312,7 +425,7 @@ void CLisFile::OpenNTI(CProgressCtrl& progress)//Halliburton
 
 		//AfxMessageBox(strName);
 
-		lisRec=new CLisRecord(nType,lCurAddr,lLen,strName);
+		lisRec=this->NewLisRecord(nType,lCurAddr,lLen,strName);
 		lisRec->nBlockNum=nBlockNum;
 		
 		lisRecordArr.Add(lisRec);	
@@ -327,6 +440,12 @@ void CLisFile::OpenNTI(CProgressCtrl& progress)//Halliburton
 	}
 
 	progress.SetPos(0);
+}
+
+void CLisFile::OpenNTI(CProgressCtrl& progress)//Halliburton
+{
+	if(!this->bIndexLoaded)
+		this->ReadNTIRecordTable(progress);
 
 	ReadDataFormatSpecificationRecord();
 		
@@ -386,8 +505,14 @@ void CLisFile::OpenNTI(CProgressCtrl& progress)//Halliburton
 	bIsFileOpen=true;
 }
 
-void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
+///////////////////////////////////////////////////////////
+// Quet file LIS (Russia): bang Blank Record, bang record (lisRecordArr)
+// va chi so cac record dac biet
+///////////////////////////////////////////////////////////
+void CLisFile::ReadLISRecordTable(CProgressCtrl& progress)
 {
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_INDEX);
+
 	CLisRecord*		pRec;
 	CBlankRecord*	pBlankRec;
 	long			lAddr=0;
@@ -400,26 +525,33 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 	BYTE			group3[4];
 	BYTE			group4[4];
 
-	hFile.Seek(0,SEEK_SET);
+	long			lPos = 0;
+	long			lFileLen = (long)hFile.GetLength();
+
+	//Tiep tuc chuoi Blank Record da duyet trong DetectFileType
+	if(blankArr.GetSize() > 0)
+	{
+		lPos = this->lBlankScanPos;
+		lAddr = this->lBlankScanAddr;
+	}
 
 	//Read Blank Table Content;
-	while(1)
+	while(blankArr.GetSize() == 0 || lPos < lFileLen-16)
 	{
-		hFile.Seek(4,SEEK_CUR);			
-		hFile.Read(group2,4);
-		hFile.Read(group3,4);
-		hFile.Read(group4,4);
+		ReadAt(lPos+4, group2, 4);
+		ReadAt(lPos+8, group3, 4);
+		ReadAt(lPos+12, group4, 4);
 
 		ParseBlankRecord(group2,group3,group4,lPrevAddr,lNextAddr,lNextRecLen);
 		nNum=int(group4[3]);
 
-		pBlankRec=new CBlankRecord(lPrevAddr,lAddr,lNextAddr,lNextRecLen,nNum);
+		pBlankRec=this->NewBlankRecord(lPrevAddr,lAddr,lNextAddr,lNextRecLen,nNum);
 		blankArr.Add(pBlankRec);
 
 		lAddr=lNextAddr;
-		hFile.Seek(lNextRecLen-4,SEEK_CUR);
+		lPos += 16 + lNextRecLen - 4;
 
-		if(hFile.GetPosition()>=hFile.GetLength()-16)
+		if(lPos>=lFileLen-16)
 			break;
 	} 
 	
@@ -446,6 +578,7 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 	nToolIdx=-1;
 	nCB3Idx=-1;
 	nCONSIdx=-1;
+	nOUTPIdx=-1;
 
 	progress.SetRange32(0, blankArr.GetSize());
 	progress.SetStep(1);
@@ -463,10 +596,7 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 		}
 
 		lAddr=pBlankRec->lAddr+16;
-		hFile.Seek(lAddr,SEEK_SET);
-		
-		hFile.Read(&nType,1);
-		hFile.Seek(1,SEEK_CUR);
+		ReadAt(lAddr, &nType, 1);
 
 		if(nType==64)
 			nDataFSRIdx=idx;
@@ -484,6 +614,7 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 		else if(nType==34)
 		{
 			strName="";
+			hFile.Seek(lAddr+2,SEEK_SET);
 			hFile.Read(&nSubType,1);
 			if(nSubType==73)
 			{
@@ -520,7 +651,7 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 		if(strName=="CONS")
 			nCONSIdx=idx;
 
-		lisRec=new CLisRecord(nType,lAddr,pBlankRec->lNextRecLen-4,strName);
+		lisRec=this->NewLisRecord(nType,lAddr,pBlankRec->lNextRecLen-4,strName);
 		//lisRec->bMultiBlock = false;
 		lisRec->nBlockNum = 1;
 		
@@ -530,6 +661,12 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 	}
 	
 	progress.SetPos(0);
+}
+
+void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
+{
+	if(!this->bIndexLoaded)
+		this->ReadLISRecordTable(progress);
 
 	ReadDataFormatSpecificationRecord();
 	
@@ -588,6 +725,11 @@ void CLisFile::OpenLIS(CProgressCtrl& progress)//Russia
 int CLisFile::OpenLisFile(CString strFN, CProgressCtrl& progress)
 {
 	CloseLisFile();
+	perfStats.Reset();
+
+	//Bang con tro tang theo khoi lon (tranh cap phat lai lien tuc)
+	blankArr.SetSize(0, LIS_ARENA_BLOCKSIZE);
+	lisRecordArr.SetSize(0, LIS_ARENA_BLOCKSIZE);
 
 	m_strFileName=strFN;
 	m_strDatFileName=m_strFileName;
@@ -598,24 +740,217 @@ int CLisFile::OpenLisFile(CString strFN, CProgressCtrl& progress)
 
 	//AfxMessageBox(m_strDatFileName);
 
+	hFile.Open(strFN,CFile::modeRead);
+
+	if(bUseMappedFile)
+		mappedFile.Open(strFN);
+
+	//Bang record lay tu file chi muc neu con khop voi file, neu khong quet file
+	bIndexLoaded = (bUseIndexCache && LoadIndexCache());
+	if(!bIndexLoaded)
+		DetectFileType();
+
+	hFile.Seek(0,SEEK_SET);			
+
+	/*if(nFileType==FILE_TYPE_NTI)
+		AfxMessageBox("Halli");
+	else
+		AfxMessageBox("Russ");*/
+
+	if(nFileType==FILE_TYPE_NTI)
+		OpenNTI(progress);
+	else
+		OpenLIS(progress);
+
+	if(bUseIndexCache && !bIndexLoaded)
+		SaveIndexCache();
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////
+// File chi muc (.cidx): loai file, bang Blank Record, bang record,
+// chi so cac record dac biet va do sau cac Data Record (khi da doc)
+///////////////////////////////////////////////////////////
+bool CLisFile::LoadIndexCache()
+{
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_INDEX);
+
+	CLisIndexCache	cache;
+	int				nInfoNum, nBlankNum, nRecNum, nNameNum;
+
+	if(!cache.Load(m_strFileName, LIS_INDEXCACHE_CLISFILE))
+		return false;
+
+	const int*				pInfo = (const int*)cache.GetSection(IDXTAG_INFO, sizeof(int), nInfoNum);
+	const LISIndexBlank*	pBlank = (const LISIndexBlank*)cache.GetSection(IDXTAG_BLANK, sizeof(LISIndexBlank), nBlankNum);
+	const LISIndexRec*		pRec = (const LISIndexRec*)cache.GetSection(IDXTAG_REC, sizeof(LISIndexRec), nRecNum);
+	const char*				pName = (const char*)cache.GetSection(IDXTAG_NAME, sizeof(char), nNameNum);
+
+	if(pInfo == NULL || nInfoNum < IDXINFO_NUM || pRec == NULL || nRecNum <= 0 || pName == NULL)
+		return false;
+	if(pBlank == NULL && nBlankNum > 0)
+		return false;
+
+	//Ten cac record: chuoi ket thuc bang 0, noi tiep nhau
+	int		nNameCount = 0;
+	for(int i = 0; i<nNameNum; i++)
+		if(pName[i] == 0)
+			nNameCount++;
+	if(nNameCount != nRecNum || pName[nNameNum-1] != 0)
+		return false;
+
+	nFileType = pInfo[IDXINFO_FILETYPE];
+	nDataFSRIdx = pInfo[IDXINFO_DATAFSR];
+	nChanIdx = pInfo[IDXINFO_CHAN];
+	nAK73Idx = pInfo[IDXINFO_AK73];
+	nToolIdx = pInfo[IDXINFO_TOOL];
+	nCB3Idx = pInfo[IDXINFO_CB3];
+	nCONSIdx = pInfo[IDXINFO_CONS];
+	nOUTPIdx = pInfo[IDXINFO_OUTP];
+	bDepthLoaded = (pInfo[IDXINFO_DEPTH] != 0);
+
+	nStartDataRec=-1;
+	nEndDataRec=-1;
+	nCurDataRec=-1;
+
+	for(int i = 0; i<nBlankNum; i++)
+		blankArr.Add(this->NewBlankRecord(pBlank[i].lPrevAddr, pBlank[i].lAddr, pBlank[i].lNextAddr,
+							pBlank[i].lNextRecLen, pBlank[i].nNum));
+
+	for(int i = 0; i<nRecNum; i++)
+	{
+		CLisRecord*	lisRec = this->NewLisRecord(pRec[i].nType, pRec[i].lAddr, pRec[i].lLen, pName);
+
+		lisRec->nBlockNum = pRec[i].nBlockNum;
+		lisRec->nFrameNum = pRec[i].nFrameNum;
+		lisRec->fDepth = pRec[i].fDepth;
+		lisRecordArr.Add(lisRec);
+
+		pName += strlen(pName) + 1;
+	}
+
+	return true;
+}
+
+bool CLisFile::SaveIndexCache()
+{
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_INDEX);
+
+	int		nRecNum = lisRecordArr.GetSize();
+	int		nBlankNum = blankArr.GetSize();
+
+	if(nRecNum <= 0)
+		return false;
+
+	CLisIndexCache	cache;
+	int				nInfo[IDXINFO_NUM];
+	LISIndexBlank*	pBlank = new LISIndexBlank[nBlankNum + 1];
+	LISIndexRec*	pRec = new LISIndexRec[nRecNum];
+	int				nNameNum = 0;
+
+	nInfo[IDXINFO_FILETYPE] = nFileType;
+	nInfo[IDXINFO_DATAFSR] = nDataFSRIdx;
+	nInfo[IDXINFO_CHAN] = nChanIdx;
+	nInfo[IDXINFO_AK73] = nAK73Idx;
+	nInfo[IDXINFO_TOOL] = nToolIdx;
+	nInfo[IDXINFO_CB3] = nCB3Idx;
+	nInfo[IDXINFO_CONS] = nCONSIdx;
+	nInfo[IDXINFO_OUTP] = nOUTPIdx;
+	nInfo[IDXINFO_DEPTH] = (bDepthRead || bDepthLoaded) ? 1 : 0;
+
+	for(int i = 0; i<nBlankNum; i++)
+	{
+		pBlank[i].lPrevAddr = blankArr[i]->lPrevAddr;
+		pBlank[i].lAddr = blankArr[i]->lAddr;
+		pBlank[i].lNextAddr = blankArr[i]->lNextAddr;
+		pBlank[i].lNextRecLen = blankArr[i]->lNextRecLen;
+		pBlank[i].nNum = blankArr[i]->nNum;
+	}
+
+	for(int i = 0; i<nRecNum; i++)
+	{
+		CLisRecord*	lisRec = lisRecordArr[i];
+
+		pRec[i].nType = lisRec->nType;
+		pRec[i].lAddr = lisRec->lAddr;
+		pRec[i].lLen = lisRec->lLen;
+		pRec[i].nBlockNum = lisRec->nBlockNum;
+		pRec[i].nFrameNum = lisRec->nFrameNum;
+		pRec[i].fDepth = lisRec->fDepth;
+
+		nNameNum += lisRec->strName.GetLength() + 1;
+	}
+
+	char*	pName = new char[nNameNum];
+	char*	pCur = pName;
+	for(int i = 0; i<nRecNum; i++)
+	{
+		strcpy(pCur, lisRecordArr[i]->strName);
+		pCur += lisRecordArr[i]->strName.GetLength() + 1;
+	}
+
+	cache.AddSection(IDXTAG_INFO, nInfo, sizeof(int), IDXINFO_NUM);
+	cache.AddSection(IDXTAG_BLANK, pBlank, sizeof(LISIndexBlank), nBlankNum);
+	cache.AddSection(IDXTAG_REC, pRec, sizeof(LISIndexRec), nRecNum);
+	cache.AddSection(IDXTAG_NAME, pName, sizeof(char), nNameNum);
+
+	bool	bOK = cache.Save(m_strFileName, LIS_INDEXCACHE_CLISFILE);
+
+	delete[] pBlank;
+	delete[] pRec;
+	delete[] pName;
+
+	return bOK;
+}
+
+///////////////////////////////////////////////////////////
+// Xac dinh loai file (LIS co Blank Record hay NTI) bang chuoi Blank
+// Record o dau file
+///////////////////////////////////////////////////////////
+void CLisFile::DetectFileType()
+{
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_DETECT);
+
+	long	lFileLen = (long)hFile.GetLength();
+	long	lPrefixLen = (lFileLen < LIS_DETECT_PREFIX) ? lFileLen : LIS_DETECT_PREFIX;
+	BYTE*	pPrefix = new BYTE[lPrefixLen + 16];
+
+	ReadAt(0, pPrefix, lPrefixLen);
+	int		nFormat = LISFileType::Detect(pPrefix, lPrefixLen, lFileLen);
+	delete[] pPrefix;
+
+	if(nFormat == LIS_FORMAT_LIS)
+	{
+		nFileType = FILE_TYPE_LIS;
+		return;
+	}
+	if(nFormat != LIS_FORMAT_MORE)//NTI hoac chuoi qua ngan
+	{
+		nFileType = FILE_TYPE_NTI;
+		return;
+	}
+
+	//Chuoi vuot qua phan dau file: duyet ca file. Cac Blank Record duoc
+	//giu lai (file LIS) de ReadLISRecordTable duyet tiep tu cho dung.
 	CBlankRecord*	pBlankRec;
 	long			lAddr=0;
 	long			lPrevAddr;
 	long			lNextAddr;
 	long			lNextRecLen;
 	int				nNum;
+	long			lLinkPos;
 
 	BYTE			group2[4];
 	BYTE			group3[4];
 	BYTE			group4[4];
 
 
-	hFile.Open(strFN,CFile::modeRead);
-
 	hFile.Seek(0,SEEK_SET);			
 	//Check whether it is a NTI or LIS file
 	while(1)
 	{
+		lLinkPos = (long)hFile.GetPosition();
 		hFile.Seek(4,SEEK_CUR);			
 		hFile.Read(group2,4);
 		hFile.Read(group3,4);
@@ -624,7 +959,7 @@ int CLisFile::OpenLisFile(CString strFN, CProgressCtrl& progress)
 		ParseBlankRecord(group2,group3,group4,lPrevAddr,lNextAddr,lNextRecLen);
 		nNum=int(group4[3]);
 
-		pBlankRec=new CBlankRecord(lPrevAddr,lAddr,lNextAddr,lNextRecLen,nNum);
+		pBlankRec=this->NewBlankRecord(lPrevAddr,lAddr,lNextAddr,lNextRecLen,nNum);
 		blankArr.Add(pBlankRec);
 
 		if(lNextAddr < 0)
@@ -659,21 +994,29 @@ int CLisFile::OpenLisFile(CString strFN, CProgressCtrl& progress)
 	else
 		nFileType = FILE_TYPE_NTI;
 
-	blankArr.RemoveAll();
-
-	hFile.Seek(0,SEEK_SET);			
+	if(nFileType == FILE_TYPE_LIS)
+	{
+		//Vi tri Blank Record tiep theo (nhu trong ReadLISRecordTable)
+		this->lBlankScanPos = lLinkPos + 16 + lNextRecLen - 4;
+		this->lBlankScanAddr = lNextAddr;
+		return;
+	}
 
-	/*if(nFileType==FILE_TYPE_NTI)
-		AfxMessageBox("Halli");
-	else
-		AfxMessageBox("Russ");*/
+	blankArr.RemoveAll();
+	blankArena.RemoveAll();
+}
 
-	if(nFileType==FILE_TYPE_NTI)
-		OpenNTI(progress);
-	else
-		OpenLIS(progress);
+//Doc nCount byte tai vi tri lAddr (tu vung anh xa neu co)
+void CLisFile::ReadAt(long lAddr, BYTE* pDst, int nCount)
+{
+	if(mappedFile.IsOpen())
+	{
+		mappedFile.Read(lAddr, pDst, nCount);
+		return;
+	}
 
-	return 0;
+	hFile.Seek(lAddr,SEEK_SET);
+	hFile.Read(pDst,nCount);
 }
 
 ///////////////////////////////////////////////////////////
@@ -683,15 +1026,33 @@ int CLisFile::OpenLisFile(CString strFN, CProgressCtrl& progress)
 ///////////////////////////////////////////////////////////
 void CLisFile::GetAllData(int nCurDataRec)
 {
-	int				nValue;
+	const BYTE*	pData;
+
+	CLisPerfScope	readScope(perfStats, LIS_PHASE_READ);
+	fCurDepth = this->ReadDataRec(nCurDataRec, pByteData, pData);
+	readScope.Stop();
+
+	CLisPerfScope	decodeScope(perfStats, LIS_PHASE_DECODE);
+	this->DecodeDataRec(nCurDataRec, pData, fFileData);
+	decodeScope.Stop();
+
+	this->CountDecoded(nCurDataRec);
+}
+
+///////////////////////////////////////////////////////////
+// Doc du lieu cua Data Record nCurDataRec: pData tro vao pBuf (kich
+// thuoc LIS_BYTEDATA_SIZE) hoac thang vao vung anh xa. Tra ve do sau
+// cua record (m). Vi tri hFile duoc giu nguyen.
+///////////////////////////////////////////////////////////
+float CLisFile::ReadDataRec(int nCurDataRec, BYTE* pBuf, const BYTE*& pData)
+{
 	BYTE			Entry[100];
 	CLisRecord*		lisRec;
+	float			fDepth;
 
 	long			lOldAddr;
 	lOldAddr=hFile.GetPosition();
 	////////////////////////////////////////////////////
-	int		nStartIdx;
-	int		nEndIdx;
 	BYTE	str[4];
 	
 	int		nContinue;
@@ -702,200 +1063,560 @@ void CLisFile::GetAllData(int nCurDataRec)
 	int		DepthRepr;
 	
 	lisRec = lisRecordArr[nCurDataRec];
+	pData = pBuf;
 
-	int		nCurveNum=0;
+	if(nFileType == FILE_TYPE_NTI)
+		hFile.Seek(lisRec->lAddr+6,SEEK_SET);
+	else
+		hFile.Seek(lisRec->lAddr+2,SEEK_SET);
 
-	for(int i = 0; i<this->datumArr.GetSize(); i++)
-		nCurveNum += datumArr[i]->nDataItemNum;
-	
-	if(this->dataFormatSpec.nDepthRecordingMode == 0)//depth per frame
-		nCurveNum -= 1;
+	if(nFileType == FILE_TYPE_NTI && mappedFile.IsOpen())
+	{
+		long	lPos = lisRec->lAddr;
+
+		mappedFile.Read(lPos, str, 4);
+		lLen=str[1]+str[0]*256;
+		nContinue=str[3];
+		lPos += 6;
+
+		DepthRepr = this->dataFormatSpec.nDepthRepr;
+		mappedFile.Read(lPos, Entry, GetCodeSize(DepthRepr));
+		fDepth=ReadCode(Entry,DepthRepr,GetCodeSize(DepthRepr));
+		lPos += GetCodeSize(DepthRepr);
 
-	/*if(nCurDataRec == 237)//237
+		index=0;
+		lLen=lLen-10;//4 for len, 2 for type, 4 for depth
+		if(nContinue == 0 && mappedFile.Contains(lPos, lLen))
+		{
+			pData = mappedFile.GetPtr(lPos);//zero-copy
+			perfStats.AddRead(lLen, 0);
+		}
+		else
+		{
+			while(1)
+			{	
+				mappedFile.Read(lPos, &pBuf[index], lLen);
+				index=index+lLen;
+				lPos += lLen;
+				
+				if(nContinue==2 || nContinue==0)	break;
+				
+				mappedFile.Read(lPos, str, 4);
+				lPos += 4;
+				lLen=str[1]+str[0]*256;
+				lLen=lLen-4;
+				nContinue=str[3];
+			}
+		}
+	}
+	else if(nFileType == FILE_TYPE_NTI)
 	{
-		int k = 0;
-	}*/
+		hFile.Seek(-6,SEEK_CUR);
+
+		//Read Size;
+		lStart=hFile.GetPosition();
+		hFile.Read(str,4);
+		lLen=str[1]+str[0]*256;
+		nContinue=str[3];
+		//Skip Type;
+		hFile.Seek(2,SEEK_CUR);
+
+		//Read Depth
+		DepthRepr = this->dataFormatSpec.nDepthRepr;
+		hFile.Read(Entry,GetCodeSize(DepthRepr));
+		fDepth=ReadCode(Entry,DepthRepr,GetCodeSize(DepthRepr));
+
+		index=0;
+		lLen=lLen-10;//4 for len, 2 for type, 4 for depth
+		if(nContinue == 0)
+		{
+			hFile.Read(&pBuf[index],lLen);
+			index=index+lLen;
+		}
+		else
+		{
+			while(1)
+			{	
+				hFile.Read(&pBuf[index],lLen);
+				index=index+lLen;
+				
+				if(nContinue==2)	break;
+				
+				hFile.Read(str,4);
+				lLen=str[1]+str[0]*256;
+				lLen=lLen-4;
+				nContinue=str[3];
+			}
+		}
+	}
+	else //Russia LIS file
+	{
+		lLen = lisRec->lLen;
+		if(mappedFile.IsOpen() && mappedFile.Contains(lisRec->lAddr+2, lLen))
+		{
+			pData = mappedFile.GetPtr(lisRec->lAddr+2);//zero-copy
+			perfStats.AddRead(lLen, 0);
+		}
+		else
+			hFile.Read(&pBuf[0],lLen);
+
+		int		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
+
+		for(int i = 0; i<nDepthSize; i++)
+			Entry[i] = pData[i];
+
+		fDepth = ReadCode(Entry,this->dataFormatSpec.nDepthRepr,nDepthSize);
+	}
+
+	fDepth = this->ConvertToMeter(fDepth, dataFormatSpec.nDepthUnit);
+
+	////////////////////////////////////////////////
+	hFile.Seek(lOldAddr,SEEK_SET);
+
+	return fDepth;
+}
+
+///////////////////////////////////////////////////////////
+// Giai ma cac frame cua Data Record nCurDataRec (pData tu ReadDataRec)
+// vao pDst. Chi doc datumArr/dataFormatSpec nen co the goi dong thoi
+// tu nhieu thread voi cac bo dem khac nhau.
+///////////////////////////////////////////////////////////
+void CLisFile::DecodeDataRec(int nCurDataRec, const BYTE* pData, float* pDst)
+{
+	int		nDepthSize;
+	int		byteDataIdx;
+
 	if(nFileType == FILE_TYPE_NTI)
-		hFile.Seek(lisRec->lAddr+6,SEEK_SET);
+	{
+		//int		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
+		nDepthSize = 4;
+		byteDataIdx = 0;
+	}
+	else //Russia LIS file: do sau nam o dau record
+	{
+		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
+		byteDataIdx = nDepthSize;
+	}
+
+	int		nFrameNum;
+	nFrameNum = this->GetFrameNum(nCurDataRec);
+	
+	int		nCurFrame = 0;
+	
+	int		fileDataIdx  = 0;
+
+	do
+	{
+		for(int i = 0; i<this->datumArr.GetSize(); i++)
+		{
+			if(i == 0 && dataFormatSpec.nDepthRecordingMode == 0) //depth per frame
+			{
+				continue;
+			}
+
+			int		nValueNum;
+
+			byteDataIdx += this->DecodeDatum(i, &pData[byteDataIdx], &pDst[fileDataIdx], nValueNum);
+			fileDataIdx += nValueNum;
+		}
+		//Bypass depth
+		if(this->dataFormatSpec.nDepthRecordingMode == 0) //Depth per frame
+			byteDataIdx+= nDepthSize;
+		
+		nCurFrame++;
+	}while(nCurFrame<nFrameNum);
+}
+
+//Cong so record/frame/gia tri cua Data Record vua giai ma vao perfStats
+void CLisFile::CountDecoded(int nCurDataRec)
+{
+	if(!perfStats.bEnabled)
+		return;
+
+	int		nFrameNum = this->GetFrameNum(nCurDataRec);
+	int		nValueNum = 0;
+
+	//DecodeDataRec luon giai ma it nhat mot frame
+	if(nFrameNum < 1)
+		nFrameNum = 1;
+
+	for(int i = 0; i<this->datumArr.GetSize(); i++)
+	{
+		if(i == 0 && dataFormatSpec.nDepthRecordingMode == 0) //depth per frame
+			continue;
+
+		if(datumArr[i]->nSize <= 4)
+			nValueNum++;
+		else
+			nValueNum += datumArr[i]->nSize/GetCodeSize(datumArr[i]->nReprCode);
+	}
+
+	perfStats.AddDecoded(1, nFrameNum, (LONGLONG)nFrameNum*nValueNum);
+}
+
+///////////////////////////////////////////////////////////
+// Giai ma gia tri cua kenh datumArr[i] bat dau tai pData vao pDst
+// (gia tri vang mat -> NULLVALUE). Tra ve so byte da doc, nValueNum:
+// so gia tri ghi vao pDst.
+///////////////////////////////////////////////////////////
+int CLisFile::DecodeDatum(int i, const BYTE* pData, float* pDst, int& nValueNum)
+{
+	BYTE	Entry[100];
+	int		byteDataIdx = 0;
+	float	fValue;
+
+	nValueNum = 0;
+
+	if(datumArr[i]->nSize <= 4)
+	{
+		for(int j = 0; j<datumArr[i]->nSize; j++)
+			Entry[j] = pData[byteDataIdx++];
+
+		fValue = ReadCode(Entry, datumArr[i]->nReprCode, datumArr[i]->nSize);	
+
+		if(fabs(fValue - this->dataFormatSpec.fAbsentValue) < 0.00001)
+			fValue = NULLVALUE;
+
+		pDst[nValueNum++] = fValue;
+	}
+	else if(datumArr[i]->nReprCode == 68 || datumArr[i]->nReprCode == 50 ||
+			datumArr[i]->nReprCode == 70)
+	{
+		//Giai ma ca mang mot lan (SIMD neu CPU ho tro)
+		int		nNb = datumArr[i]->nSize/GetCodeSize(datumArr[i]->nReprCode);
+		if(datumArr[i]->nReprCode == 68)
+			LISReprCode::Decode68(pData, nNb, pDst, true);
+		else
+			LISReprCode::DecodeBatch(pData, datumArr[i]->nReprCode, nNb, pDst);
+		byteDataIdx += nNb*4;
+		for(int j = 0; j<nNb; j++, nValueNum++)
+		{
+			if(fabs(pDst[nValueNum] - this->dataFormatSpec.fAbsentValue) < 0.00001)
+				pDst[nValueNum] = NULLVALUE;
+		}
+	}
 	else
-		hFile.Seek(lisRec->lAddr+2,SEEK_SET);
+	{
+		int		nNb = datumArr[i]->nSize/GetCodeSize(datumArr[i]->nReprCode);
+		for(int j = 0; j<nNb; j++)
+		{
+			for(int k = 0; k < GetCodeSize(datumArr[i]->nReprCode); k++)
+				Entry[k] = pData[byteDataIdx++];
+			fValue = ReadCode(Entry, datumArr[i]->nReprCode, datumArr[i]->nSize);	
+			if(fabs(fValue - this->dataFormatSpec.fAbsentValue) < 0.00001)
+				fValue = NULLVALUE;
+			pDst[nValueNum++] = fValue;
+		}
+	}
+
+	return byteDataIdx;
+}
+
+///////////////////////////////////////////////////////////
+// Doc nCount byte tu byte nOffset cua du lieu Data Record nCurDataRec
+// (nhu pData cua ReadDataRec) ma khong doc ca record. NTI: duyet header
+// cac block noi tiep de bo qua 4 byte header cua moi block.
+///////////////////////////////////////////////////////////
+bool CLisFile::ReadDataRecRange(int nCurDataRec, int nOffset, BYTE* pDst, int nCount)
+{
+	CLisRecord*		lisRec = lisRecordArr[nCurDataRec];
+
+	if(nFileType != FILE_TYPE_NTI)//Russia LIS file: record lien tuc
+	{
+		if(nOffset + nCount > lisRec->lLen)
+			return false;
+
+		this->ReadAt(lisRec->lAddr + 2 + nOffset, pDst, nCount);
+		return true;
+	}
+
+	BYTE	str[4];
+	long	lPos = lisRec->lAddr;
+	int		nBlockStart = 0;//Vi tri du lieu cua block trong record
+
+	this->ReadAt(lPos, str, 4);
+	long	lLen = str[1]+str[0]*256;
+	int		nContinue = str[3];
+
+	lPos += 6 + GetCodeSize(this->dataFormatSpec.nDepthRepr);
+	lLen = lLen - 10;//4 for len, 2 for type, 4 for depth
+
+	while(nCount > 0 && lLen >= 0)
+	{
+		if(nOffset < nBlockStart + lLen)
+		{
+			int		nSkip = nOffset - nBlockStart;
+			int		n = (int)lLen - nSkip;
+
+			if(n > nCount)
+				n = nCount;
+
+			this->ReadAt(lPos + nSkip, pDst, n);
+			pDst += n;
+			nOffset += n;
+			nCount -= n;
+		}
+
+		if(nContinue == 2 || nContinue == 0)
+			break;
+
+		nBlockStart += (int)lLen;
+		lPos += lLen;
+
+		this->ReadAt(lPos, str, 4);
+		lPos += 4;
+		lLen = str[1]+str[0]*256;
+		lLen = lLen-4;
+		nContinue = str[3];
+	}
+
+	return (nCount == 0);
+}
+
+///////////////////////////////////////////////////////////
+// Doc va giai ma gia tri cua kenh nDatum tai frame nFrame cua Data
+// Record nCurDataRec, chi doc cac byte cua kenh (cung bo cuc frame nhu
+// DecodeDataRec). Tra ve so gia tri ghi vao pDst, 0 neu khong hop le.
+///////////////////////////////////////////////////////////
+int CLisFile::ReadChannelSlice(int nDatum, int nCurDataRec, int nFrame, float* pDst)
+{
+	bool	bDepthInFrame = (dataFormatSpec.nDepthRecordingMode == 0);
+
+	if(nDatum < 0 || nDatum >= datumArr.GetSize() || (nDatum == 0 && bDepthInFrame))
+		return 0;
+	if(nCurDataRec < 0 || nCurDataRec >= lisRecordArr.GetSize() || lisRecordArr[nCurDataRec]->nType != 0)
+		return 0;
+	if(nFrame < 0 || nFrame >= this->GetFrameNum(nCurDataRec))
+		return 0;
+
+	int		nDepthSize;
+	int		nOffset;
+
+	if(nFileType == FILE_TYPE_NTI)
+	{
+		nDepthSize = 4;
+		nOffset = 0;
+	}
+	else //Russia LIS file: do sau nam o dau record
+	{
+		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
+		nOffset = nDepthSize;
+	}
+
+	//Kich thuoc frame va vi tri kenh trong frame
+	int		nFrameSize = bDepthInFrame ? nDepthSize : 0;
+	int		nDatumPos = 0;
+
+	for(int i = (bDepthInFrame ? 1 : 0); i<datumArr.GetSize(); i++)
+	{
+		if(i == nDatum)
+			nDatumPos = nFrameSize - (bDepthInFrame ? nDepthSize : 0);
+		nFrameSize += datumArr[i]->nSize;
+	}
+
+	int		nSize = datumArr[nDatum]->nSize;
+	BYTE	byteArr[1024];
+	BYTE*	pBytes = (nSize <= (int)sizeof(byteArr)) ? byteArr : new BYTE[nSize];
+	int		nValueNum = 0;
+
+	nOffset += nFrame * nFrameSize + nDatumPos;
+
+	if(this->ReadDataRecRange(nCurDataRec, nOffset, pBytes, nSize))
+		this->DecodeDatum(nDatum, pBytes, pDst, nValueNum);
+
+	if(pBytes != byteArr)
+		delete[] pBytes;
+
+	return nValueNum;
+}
+
+//Gia tri cua kenh nDatum tai dong gan do sau fDepth (m) nhat (depthIndex):
+//chi nRealSize gia tri cua sample ung voi dong do. Nhu WriteToDatFile:
+//dong thu i cua frame co do sau do sau frame + i*lStep/nMaxNbSample,
+//ke ca huong UP, va lay sample min(i, nNbSample - 1) cua kenh.
+int CLisFile::ReadChannelSlice(int nDatum, float fDepth, float* pDst)
+{
+	int		nRec;
+	int		nFrame;
+	int		nSample;
+	int		nMaxNbSample = 1;
+
+	for(int i = 0; i<this->datumArr.GetSize(); i++)
+		if(this->datumArr[i]->nNbSample > nMaxNbSample)
+			nMaxNbSample = this->datumArr[i]->nNbSample;
 
-	if(nFileType == FILE_TYPE_NTI)
+	this->ReadAllDepth();
+	if(!this->depthIndex.FindFrame(fDepth, nMaxNbSample, 1, nRec, nFrame, nSample))
+		return 0;
+	if(nDatum < 0 || nDatum >= datumArr.GetSize())
+		return 0;
+
+	//Giai ma ca kenh trong frame roi chi chep sample nSample
+	float	fValueArr[256];
+	float*	pValues = (datumArr[nDatum]->nSize <= 256) ? fValueArr : new float[datumArr[nDatum]->nSize];
+	int		nValueNum = this->ReadChannelSlice(nDatum, nRec, nFrame, pValues);
+	int		nRealSize = datumArr[nDatum]->nRealSize;
+
+	if(nSample >= datumArr[nDatum]->nNbSample)
+		nSample = datumArr[nDatum]->nNbSample - 1;
+
+	int		nFirst = nSample * nRealSize;
+
+	if(nValueNum <= 1)//Kenh mot gia tri (nSize <= 4)
 	{
-		hFile.Seek(-6,SEEK_CUR);
+		nFirst = 0;
+		nRealSize = nValueNum;
+	}
+	else if(nFirst + nRealSize > nValueNum)
+		nRealSize = 0;
 
-		//Read Size;
-		lStart=hFile.GetPosition();
-		hFile.Read(str,4);
-		lLen=str[1]+str[0]*256;
-		nContinue=str[3];
-		//Skip Type;
-		hFile.Seek(2,SEEK_CUR);
+	for(int i = 0; i<nRealSize; i++)
+		pDst[i] = pValues[nFirst + i];
 
-		//Skip depth;
-		//hFile.Seek(4,SEEK_CUR);
+	if(pValues != fValueArr)
+		delete[] pValues;
 
-		//Read Depth
-		//hFile.Read(Entry,GetCodeSize(68));
-		//fCurDepth=ReadCode(Entry,68,GetCodeSize(68));
-		DepthRepr = this->dataFormatSpec.nDepthRepr;
-		hFile.Read(Entry,GetCodeSize(DepthRepr));
-		fCurDepth=ReadCode(Entry,DepthRepr,GetCodeSize(DepthRepr));
+	return nRealSize;
+}
 
-		index=0;
-		lLen=lLen-10;//4 for len, 2 for type, 4 for depth
-		if(nContinue == 0)
-		{
-			hFile.Read(&pByteData[index],lLen);
-			index=index+lLen;
-		}
-		else
-		{
-			while(1)
-			{	
-				hFile.Read(&pByteData[index],lLen);
-				index=index+lLen;
-				
-				if(nContinue==2)	break;
-				
-				hFile.Read(str,4);
-				lLen=str[1]+str[0]*256;
-				lLen=lLen-4;
-				nContinue=str[3];
-			}
-		}
+//Cong doan doc: chi thread doc dung hFile trong khi pipeline chay
+static void CLisPipelineReadProc(int nItem, int nSlot, void* pParam)
+{
+	CLisFile*	pLis = (CLisFile*)pParam;
+	int			nCurDataRec;
 
-		
-		//int		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
-		int		nDepthSize = 4;
-		int		byteDataIdx = 0;
+	if(pLis->bPipelineReverse)
+		nCurDataRec = pLis->nEndDataRec - nItem;
+	else
+		nCurDataRec = pLis->nStartDataRec + nItem;
 
-		fCurDepth = this->ConvertToMeter(fCurDepth, dataFormatSpec.nDepthUnit);
+	pLis->pSlotRec[nSlot] = nCurDataRec;
+	pLis->pSlotDepth[nSlot] = pLis->ReadDataRec(nCurDataRec, pLis->pSlotByteData[nSlot], pLis->pSlotData[nSlot]);
+}
 
-		int		nFrameNum;
-		nFrameNum = this->GetFrameNum(nCurDataRec);
-		
-		int		nCurFrame = 0;
-		
-		int		fileDataIdx  = 0;
-		float	fValue;
+static void CLisPipelineDecodeProc(int nItem, int nSlot, void* pParam)
+{
+	CLisFile*	pLis = (CLisFile*)pParam;
 
-		do
-		{
-			for(int i = 0; i<this->datumArr.GetSize(); i++)
-			{
-				if(i == 0 && dataFormatSpec.nDepthRecordingMode == 0) //depth per frame
-				{
-					continue;
-				}
-				
-				if(datumArr[i]->nSize <= 4)
-				{
-					for(int j = 0; j<datumArr[i]->nSize; j++)
-						Entry[j] = pByteData[byteDataIdx++];
+	pLis->DecodeDataRec(pLis->pSlotRec[nSlot], pLis->pSlotData[nSlot], pLis->pSlotFileData[nSlot]);
+}
 
-					
-					fValue = ReadCode(Entry, datumArr[i]->nReprCode, datumArr[i]->nSize);	
-					
-					
-					if(fabs(fValue - this->dataFormatSpec.fAbsentValue) < 0.00001)
-						fValue = NULLVALUE;
-					
-					fFileData[fileDataIdx++] = fValue;
-				}
-				else
-				{
-					int		nNb = datumArr[i]->nSize/GetCodeSize(datumArr[i]->nReprCode);
-					for(int j = 0; j<nNb; j++)
-					{
-						for(int k = 0; k < GetCodeSize(datumArr[i]->nReprCode); k++)
-							Entry[k] = pByteData[byteDataIdx++];
-						//fFileData[fileDataIdx++] = ReadCode(Entry, datumArr[i]->nReprCode, GetCodeSize(datumArr[i]->nReprCode));
-						fValue = ReadCode(Entry, datumArr[i]->nReprCode, datumArr[i]->nSize);	
-						if(fabs(fValue - this->dataFormatSpec.fAbsentValue) < 0.00001)
-							fValue = NULLVALUE;
-						fFileData[fileDataIdx++] = fValue;
-					}
-				}
-			}
-			//Bypass depth
-			if(this->dataFormatSpec.nDepthRecordingMode == 0) //Depth per frame
-				byteDataIdx+= nDepthSize;
-			
-			nCurFrame++;
-		}while(nCurFrame<nFrameNum);
+///////////////////////////////////////////////////////////
+// Bat dau pipeline cho cac Data Record nStartDataRec..nEndDataRec
+// (bReverse: tu nEndDataRec ve). Sau do FetchDataRec phai duoc goi
+// dung theo thu tu do (goi sai thu tu: pipeline dung lai, cac record
+// con lai doc tuan tu). Tra ve false: doc tuan tu bang GetAllData.
+///////////////////////////////////////////////////////////
+bool CLisFile::StartPipeline(bool bReverse)
+{
+	StopPipeline();
+
+	int		nItemNum = this->nEndDataRec - this->nStartDataRec + 1;
+	int		nDepth = this->nPipelineDepth;
+
+	if(this->nDecodeThreadNum == 1 || nItemNum <= 1)
+		return false;
+	if(nDepth < 2)
+		nDepth = 2;
+
+	this->pSlotByteData = new BYTE*[nDepth];
+	this->pSlotData = new const BYTE*[nDepth];
+	this->pSlotFileData = new float*[nDepth];
+	this->pSlotDepth = new float[nDepth];
+	this->pSlotRec = new int[nDepth];
+	this->nPipelineSlotNum = nDepth;
+	for(int i = 0; i<nDepth; i++)
+	{
+		this->pSlotByteData[i] = new BYTE[LIS_BYTEDATA_SIZE];
+		this->pSlotFileData[i] = new float[LIS_FILEDATA_SIZE];
 	}
-	else //Russia LIS file
+
+	this->nPipelineItem = 0;
+	this->bPipelineReverse = bReverse;
+	this->nDecodeErrorNum = 0;
+	this->bShowErrors = false;
+
+	if(!this->pipeline.Start(nItemNum, CLisPipelineReadProc, CLisPipelineDecodeProc, this,
+							nDepth, this->nDecodeThreadNum))
 	{
-		lLen = lisRec->lLen;
-		hFile.Read(&pByteData[0],lLen);
+		StopPipeline();
+		return false;
+	}
 
-		int		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
-		int		byteDataIdx;
+	return true;
+}
 
-		for(byteDataIdx = 0; byteDataIdx<nDepthSize; byteDataIdx++)
-			Entry[byteDataIdx] = pByteData[byteDataIdx];
+//Du lieu da giai ma cua Data Record nCurDataRec (dat fCurDepth)
+float* CLisFile::FetchDataRec(int nCurDataRec)
+{
+	if(!this->pipeline.IsRunning())
+	{
+		this->GetAllData(nCurDataRec);
+		return fFileData;
+	}
 
-		fCurDepth = ReadCode(Entry,this->dataFormatSpec.nDepthRepr,nDepthSize);
+	//Record truoc da ghi xong: tra slot cho thread doc
+	if(this->nPipelineItem > 0)
+		this->pipeline.ReleaseItem(this->nPipelineItem - 1);
 
-		fCurDepth = this->ConvertToMeter(fCurDepth, dataFormatSpec.nDepthUnit);
+	CLisPerfScope	decodeScope(perfStats, LIS_PHASE_DECODE);
+	int				nSlot = this->pipeline.WaitItem(this->nPipelineItem++);
+	decodeScope.Stop();
 
-		int		nFrameNum;
-		nFrameNum = this->GetFrameNum(nCurDataRec);
-		
-		int		nCurFrame = 0;
-		
-		int		fileDataIdx  = 0;
-		float	fValue;
+	//Pipeline tra record theo thu tu StartPipeline: goi khac thu tu do
+	//thi dung pipeline va doc record duoc yeu cau
+	ASSERT(this->pSlotRec[nSlot] == nCurDataRec);
+	if(this->pSlotRec[nSlot] != nCurDataRec)
+	{
+		StopPipeline();
+		this->GetAllData(nCurDataRec);
+		return fFileData;
+	}
 
-		do
-		{
-			for(int i = 0; i<this->datumArr.GetSize(); i++)
-			{
-				if(i == 0 && dataFormatSpec.nDepthRecordingMode == 0) //depth per frame
-				{
-					continue;
-				}
-				
-				if(datumArr[i]->nSize <= 4)
-				{
-					for(int j = 0; j<datumArr[i]->nSize; j++)
-						Entry[j] = pByteData[byteDataIdx++];
+	this->CountDecoded(this->pSlotRec[nSlot]);
 
-					
-					fValue = ReadCode(Entry, datumArr[i]->nReprCode, datumArr[i]->nSize);	
-					
-					
-					if(fabs(fValue - this->dataFormatSpec.fAbsentValue) < 0.00001)
-						fValue = NULLVALUE;
-					
-					fFileData[fileDataIdx++] = fValue;
-				}
-				else
-				{
-					int		nNb = datumArr[i]->nSize/GetCodeSize(datumArr[i]->nReprCode);
-					for(int j = 0; j<nNb; j++)
-					{
-						for(int k = 0; k < GetCodeSize(datumArr[i]->nReprCode); k++)
-							Entry[k] = pByteData[byteDataIdx++];
-						//fFileData[fileDataIdx++] = ReadCode(Entry, datumArr[i]->nReprCode, GetCodeSize(datumArr[i]->nReprCode));
-						fValue = ReadCode(Entry, datumArr[i]->nReprCode, datumArr[i]->nSize);	
-						if(fabs(fValue - this->dataFormatSpec.fAbsentValue) < 0.00001)
-							fValue = NULLVALUE;
-						fFileData[fileDataIdx++] = fValue;
-					}
-				}
-			}
-			//Bypass depth
-			if(this->dataFormatSpec.nDepthRecordingMode == 0) //Depth per frame
-				byteDataIdx+= nDepthSize;
-			
-			nCurFrame++;
-		}while(nCurFrame<nFrameNum);
+	fCurDepth = this->pSlotDepth[nSlot];
+	return this->pSlotFileData[nSlot];
+}
+
+void CLisFile::StopPipeline()
+{
+	int		nDepth = this->nPipelineSlotNum;
+
+	if(this->pipeline.IsRunning())
+	{
+		this->pipeline.Stop();
+		this->pipelineStats = this->pipeline.stats;
 	}
+	this->bShowErrors = true;
 
-	////////////////////////////////////////////////
-	hFile.Seek(lOldAddr,SEEK_SET);
+	//Loi giai ma cua cac thread pipeline: bao mot lan tren thread goi
+	if(this->nDecodeErrorNum > 0)
+	{
+		this->nDecodeErrorNum = 0;
+		MessageBox(NULL,"ReadCode","Error",MB_OK);
+	}
+
+	if(this->pSlotByteData != NULL)
+	{
+		for(int i = 0; i<nDepth; i++)
+		{
+			delete[] this->pSlotByteData[i];
+			delete[] this->pSlotFileData[i];
+		}
+		delete[] this->pSlotByteData;
+		delete[] this->pSlotData;
+		delete[] this->pSlotFileData;
+		delete[] this->pSlotDepth;
+		delete[] this->pSlotRec;
+
+		this->pSlotByteData = NULL;
+		this->pSlotData = NULL;
+		this->pSlotFileData = NULL;
+		this->pSlotDepth = NULL;
+		this->pSlotRec = NULL;
+		this->nPipelineSlotNum = 0;
+	}
 }
 
 //////////////////////////////////////////////////////////
@@ -978,6 +1699,13 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 	file1.Write(&lSmallStep, sizeof(long));
 	file1.Write(&nMaxNbSample, sizeof(int));
 
+	//Chi doc va giai ma cac record trong khoang do sau [fTop, fBottom]
+	int		nOldStartDataRec = this->nStartDataRec;
+	int		nOldEndDataRec = this->nEndDataRec;
+
+	if(!this->GetDataRecRange(fTop, fBottom, this->nStartDataRec, this->nEndDataRec))
+		this->nEndDataRec = this->nStartDataRec - 1;
+
 	if(m_Process != NULL)
 	{
 		m_Process->SetRange(0, this->nEndDataRec - this->nStartDataRec);
@@ -985,6 +1713,11 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 		m_Process->SetPos(0);
 	}
 
+	//Doc va giai ma truoc cac record tren cac thread khac (theo thu tu ghi)
+	float*	pRecData;
+
+	this->StartPipeline(this->dataFormatSpec.nDirection == 1);
+
 	if(nFileType == FILE_TYPE_NTI)//Halliburton
 	{
 		long	lCurDepth;
@@ -1011,8 +1744,9 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 				nCurDataRec>=nStartDataRec;nCurDataRec--)
 			{
 				nFrameNum = this->GetFrameNum(nCurDataRec);
-				this->GetAllData(nCurDataRec);
+				pRecData = this->FetchDataRec(nCurDataRec);
 				
+				CLisPerfScope	writeScope(perfStats, LIS_PHASE_WRITE);
 				lCurDepth = long(fCurDepth*1000);
 
 				lCurDepth = lCurDepth - (nFrameNum-1)*lStep;
@@ -1024,7 +1758,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 					if(nMaxNbSample <= 1)
 					{
 						file1.Write(&lCurDepth, sizeof(long));
-						file1.Write(&fFileData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
+						file1.Write(&pRecData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
 					}
 					else
 					{
@@ -1037,7 +1771,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 							{
 								float*	pt = fWriteData[j];
 								for(int k = 0; k<this->datumArr[i]->nRealSize;k++)
-									pt[startIdx + k] = fFileData[nCurFrame*nCurveNum + dataItemIdx + k];
+									pt[startIdx + k] = pRecData[nCurFrame*nCurveNum + dataItemIdx + k];
 								if(this->datumArr[i]->nNbSample > j+1)
 									dataItemIdx += this->datumArr[i]->nRealSize;
 							}
@@ -1084,8 +1818,9 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 				nCurDataRec<=nEndDataRec;nCurDataRec++)
 			{
 				nFrameNum = this->GetFrameNum(nCurDataRec);
-				this->GetAllData(nCurDataRec);
+				pRecData = this->FetchDataRec(nCurDataRec);
 				
+				CLisPerfScope	writeScope(perfStats, LIS_PHASE_WRITE);
 				lCurDepth = long(fCurDepth*1000);
 
 				//lCurDepth = lCurDepth - (nFrameNum-1)*lStep;
@@ -1098,7 +1833,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 					if(nMaxNbSample <= 1)
 					{
 						file1.Write(&lCurDepth, sizeof(long));
-						file1.Write(&fFileData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
+						file1.Write(&pRecData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
 					}
 					else
 					{
@@ -1111,7 +1846,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 							{
 								float*	pt = fWriteData[j];
 								for(int k = 0; k<this->datumArr[i]->nRealSize;k++)
-									pt[startIdx + k] = fFileData[nCurFrame*nCurveNum + dataItemIdx + k];
+									pt[startIdx + k] = pRecData[nCurFrame*nCurveNum + dataItemIdx + k];
 								if(this->datumArr[i]->nNbSample > j+1)
 									dataItemIdx += this->datumArr[i]->nRealSize;
 							}
@@ -1156,8 +1891,9 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 				nCurDataRec>=nStartDataRec;nCurDataRec--)
 			{
 				nFrameNum = this->GetFrameNum(nCurDataRec);
-				this->GetAllData(nCurDataRec);
+				pRecData = this->FetchDataRec(nCurDataRec);
 				
+				CLisPerfScope	writeScope(perfStats, LIS_PHASE_WRITE);
 				lCurDepth = long(fCurDepth*1000);
 
 				//fCurDepth = fCurDepth - (nFrameNum-1)*(lStep/1000.0);
@@ -1171,7 +1907,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 					//fCurDepth = float(lCurDepth)/1000.0;
 					//file1.Write(&this->fCurDepth, sizeof(float));
 					file1.Write(&lCurDepth, sizeof(long));
-					file1.Write(&fFileData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
+					file1.Write(&pRecData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
 
 					nCurFrame--;
 					//fCurDepth += (lStep/1000.0);
@@ -1205,8 +1941,9 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 				nCurDataRec<=nEndDataRec;nCurDataRec++)
 			{
 				nFrameNum = this->GetFrameNum(nCurDataRec);
-				this->GetAllData(nCurDataRec);
+				pRecData = this->FetchDataRec(nCurDataRec);
 				
+				CLisPerfScope	writeScope(perfStats, LIS_PHASE_WRITE);
 				lCurDepth = long(fCurDepth*1000);
 
 				//fCurDepth = fCurDepth - (nFrameNum-1)*(lStep/1000.0);
@@ -1220,7 +1957,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 					//fCurDepth = float(lCurDepth)/1000.0;
 					//file1.Write(&this->fCurDepth, sizeof(float));
 					file1.Write(&lCurDepth, sizeof(long));
-					file1.Write(&fFileData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
+					file1.Write(&pRecData[nCurFrame*nCurveNum], sizeof(float)*nCurveNum);
 
 					nCurFrame++;
 					//fCurDepth += (lStep/1000.0);
@@ -1232,6 +1969,7 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 			}
 		}
 	}
+	this->StopPipeline();
 	file1.Close();
 	
 	/*if(nCurDataRec == nEndDataRec - 2500)
@@ -1249,6 +1987,9 @@ void	CLisFile::WriteToDatFile(float fTop, float fBottom,  CProgressCtrl* m_Proce
 		fwrite(str.GetBuffer(), 1, str.GetLength(), file2);
 	}*/
 	//fclose(file2);
+	this->nStartDataRec = nOldStartDataRec;
+	this->nEndDataRec = nOldEndDataRec;
+
 	if(m_Process != NULL)
 		m_Process->SetPos(0);
 }
@@ -1323,89 +2064,25 @@ float CLisFile::ReadCode(BYTE Entry[], BYTE nReprCode, BYTE nSize)
 
 	if(nReprCode==68)//so thuc 32 bit
 	{
-		unsigned char	ch[4];
-		unsigned int	nResult=0;
 		float			fResult;
-		float			lExponent;
-		float			fFraction;
-		unsigned int	ntemp;
-	
-		CString str;
 
-		ch[0]=unsigned char(Entry[0]);
-		ch[1]=unsigned char(Entry[1]);
-		ch[2]=unsigned char(Entry[2]);
-		ch[3]=unsigned char(Entry[3]);
+		LISReprCode::Decode68(Entry, 1, &fResult, true);
+		return fResult;
+	}
 
-		ntemp=int(ch[0]);
-		ntemp=ntemp<<24;
-		nResult=nResult | ntemp;
-		ntemp=int(ch[1]);
-		ntemp=ntemp<<16;
-		nResult=nResult | ntemp;
-		ntemp=int(ch[2]);
-		ntemp=ntemp<<8;
-		nResult=nResult | ntemp;
-		ntemp=int(ch[3]);	
-		nResult=nResult | ntemp;
-		if(ch[0]>=128)//negative number
-		{
-			//Calculate Exponent
-			ntemp=nResult & 0x7f800000;
-			ntemp=ntemp>>23;
-			if(ntemp<=127)
-				lExponent=pow(2,127-ntemp);
-			else
-			{
-				//lExponent=1.0/pow(2,ntemp-127);
-				lExponent = 1.0;
-				for(int ii = 0; ii<ntemp - 127; ii++)
-					lExponent/=2.0;
-			}
-			//Calculate Fraction
-			ntemp=nResult & 0x7fffff;
-			ntemp=~ntemp;
-			ntemp=ntemp+1;
-			ntemp=ntemp<<9;
-			float	fFactor=0.5;
-			fFraction=0;		
-			do
-			{
-				if(ntemp>=0x80000000)
-					fFraction+=fFactor;
-				fFactor/=2;
-				ntemp=ntemp<<1;			
-			}while(ntemp>0) ;
-			fResult=(-1.0)*fFraction*float(lExponent);
-		}
-		else// positive
-		{
-			//Calculate Exponent
-			ntemp=nResult & 0x7f800000;
-			ntemp=ntemp>>23;
-			if(ntemp>=128)
-				lExponent=pow(2,ntemp-128);
-			else
-			{
-				//lExponent=1.0/pow(2,128-ntemp);
-				lExponent = 1.0;
-				for(int ii = 0; ii<128-ntemp; ii++)
-					lExponent /=2.0;
-			}
-			//Calculate Fraction
-			ntemp=nResult & 0x7fffff;
-			ntemp=ntemp<<9;
-			float	fFactor=0.5;
-			fFraction=0;		
-			do
-			{
-				if(ntemp>=0x80000000)
-					fFraction+=fFactor;
-				fFactor/=2;
-				ntemp=ntemp<<1;			
-			}while(ntemp>0) ;
-			fResult=fFraction*float(lExponent);
-		}
+	if(nReprCode==50)//so thuc 32 bit do phan giai thap: E 16 bit, M 16 bit
+	{
+		float			fResult;
+
+		LISReprCode::DecodeBatch(Entry, 50, 1, &fResult);
+		return fResult;
+	}
+
+	if(nReprCode==70)//so fix point 32 bit (16 bit le)
+	{
+		float			fResult;
+
+		LISReprCode::DecodeBatch(Entry, 70, 1, &fResult);
 		return fResult;
 	}
 
@@ -1466,7 +2143,11 @@ float CLisFile::ReadCode(BYTE Entry[], BYTE nReprCode, BYTE nSize)
 	}
 
 
-	MessageBox(NULL,"ReadCode","Error",MB_OK);
+	//Tren thread cua pipeline: chi dem, StopPipeline bao tren thread goi
+	if(this->bShowErrors)
+		MessageBox(NULL,"ReadCode","Error",MB_OK);
+	else
+		InterlockedIncrement(&this->nDecodeErrorNum);
 	return -1;
 }
 int CLisFile::GetCodeSize(BYTE nCode)
@@ -1512,6 +2193,8 @@ int CLisFile::GetCodeType(BYTE nCode)
 }
 void CLisFile::ReadDataFormatSpecificationRecord()
 {
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_DFSR);
+
 	if(nDataFSRIdx<0)
 		return;
 
@@ -1979,6 +2662,8 @@ float	CLisFile::ConvertToMeter(float fDepth, int nMode)
 }
 float CLisFile::GetStartDepth()
 {
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_DEPTH);
+
 	float		fDepth = -1;
 
 	if(this->dataFormatSpec.nDepthRecordingMode == 0)//depth per frame
@@ -2018,6 +2703,8 @@ float CLisFile::GetStartDepth()
 
 float CLisFile::GetEndDepth()
 {
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_DEPTH);
+
 	float		fDepth;
 
 	if(this->dataFormatSpec.nDepthRecordingMode == 0)//depth per frame
@@ -2077,75 +2764,17 @@ float CLisFile::GetEndDepth()
 }
 
 
+///////////////////////////////////////////////////////////
+// Xac dinh khoang Data Record lien tuc dai nhat va buoc do sau.
+// Chi doc do sau cua hai record dau (khi can tinh fFrameSpacing);
+// do sau cua tat ca record va depthIndex duoc doc khi can (ReadAllDepth):
+// sau ReadDepth, lisRecordArr[i]->fDepth con la -999.25 cho toi khi
+// ReadAllDepth chay; nguoi goi doc do sau qua GetRecDepth.
+///////////////////////////////////////////////////////////
 void CLisFile::ReadDepth()
 {
-	for(int nCurDataRec=nStartDataRec; 	
-				nCurDataRec<=nEndDataRec;nCurDataRec++)
-	{
-		CLisRecord*		lisRec;
-
-		////////////////////////////////////////////////////
-		int		nStartIdx;
-		int		nEndIdx;
-		BYTE	str[4];
-		BYTE	Entry[256];
-		float	fCurDepth;
-
-		long	lLen;
-		long	lStart;
-		int		index;
-	
-		lisRec = lisRecordArr[nCurDataRec];
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_DEPTH);
 
-		if(lisRec->nType != 0)
-			continue;
-		
-		if(nFileType == FILE_TYPE_NTI)
-			hFile.Seek(lisRec->lAddr+6,SEEK_SET);
-		else
-			hFile.Seek(lisRec->lAddr+2,SEEK_SET);
-
-		if(nFileType == FILE_TYPE_NTI)
-		{
-			hFile.Seek(-6,SEEK_CUR);
-
-			//Read Size;
-			lStart=hFile.GetPosition();
-			hFile.Read(str,4);
-			lLen=str[1]+str[0]*256;
-			//nContinue=str[3];
-			//Skip Type;
-			hFile.Seek(2,SEEK_CUR);
-
-			//Read Depth
-			hFile.Read(Entry,GetCodeSize(68));
-			//hFile.Read(Entry,100);
-			fCurDepth=ReadCode(Entry,68,GetCodeSize(68));
-
-			int		nDepthSize = 4;
-			int		byteDataIdx = 0;
-		
-			fCurDepth = this->ConvertToMeter(fCurDepth, dataFormatSpec.nDepthUnit);
-		}
-		else //Russia LIS file
-		{
-			lLen = lisRec->lLen;
-			hFile.Read(&pByteData[0],lLen);
-
-			int		nDepthSize = GetCodeSize(this->dataFormatSpec.nDepthRepr);
-			int		byteDataIdx;
-
-			for(byteDataIdx = 0; byteDataIdx<nDepthSize; byteDataIdx++)
-				Entry[byteDataIdx] = pByteData[byteDataIdx];
-
-			fCurDepth = ReadCode(Entry,this->dataFormatSpec.nDepthRepr,nDepthSize);
-
-			fCurDepth = this->ConvertToMeter(fCurDepth, dataFormatSpec.nDepthUnit);
-		}
-		lisRec->fDepth = fCurDepth;
-	}
-
-	//Recalculate 
 	//int				nCurDataRec=nStartDataRec;
 	CLisRecord*		lisRec;
 	int				startArr[100];
@@ -2154,6 +2783,10 @@ void CLisFile::ReadDepth()
 
 	int				nCurDataRec1=nStartDataRec;
 
+	//Do sau cua moi Data Record (ke ca ngoai khoang duoc chon) doc sau
+	this->nDepthStartRec = nStartDataRec;
+	this->nDepthEndRec = nEndDataRec;
+
 	while(1)
 	{
 		lisRec = lisRecordArr[nCurDataRec1];
@@ -2208,10 +2841,10 @@ void CLisFile::ReadDepth()
 		float			fDepth1, fDepth2;
 
 		lisRec = lisRecordArr[nStartDataRec];
-		fDepth1 = lisRec->fDepth;
+		fDepth1 = lisRec->fDepth = this->ReadRecDepth(nStartDataRec);
 
 		lisRec = lisRecordArr[nStartDataRec+1];
-		fDepth2 = lisRec->fDepth;
+		fDepth2 = lisRec->fDepth = this->ReadRecDepth(nStartDataRec+1);
 
 		int nFrameNum;
 
@@ -2221,6 +2854,154 @@ void CLisFile::ReadDepth()
 
 		this->lStep = this->dataFormatSpec.fFrameSpacing*1000;
 	}
+
+	this->depthIndex.RemoveAll();
+	this->bDepthRead = false;
+}
+
+///////////////////////////////////////////////////////////
+// Vi tri (trong file) va ma bieu dien cua gia tri do sau o dau
+// Data Record nCurDataRec
+///////////////////////////////////////////////////////////
+long CLisFile::GetDepthAddr(int nCurDataRec)
+{
+	if(nFileType == FILE_TYPE_NTI)
+		return lisRecordArr[nCurDataRec]->lAddr + 6;//4 for len, 2 for type
+
+	return lisRecordArr[nCurDataRec]->lAddr + 2;
+}
+
+int CLisFile::GetDepthReprCode()
+{
+	if(nFileType == FILE_TYPE_NTI)
+		return 68;
+
+	return this->dataFormatSpec.nDepthRepr;
+}
+
+//Do sau (m) cua Data Record nCurDataRec, chi doc cac byte do sau
+float CLisFile::ReadRecDepth(int nCurDataRec)
+{
+	BYTE	Entry[256];
+	int		nReprCode = this->GetDepthReprCode();
+	int		nSize = GetCodeSize(nReprCode);
+
+	this->ReadAt(this->GetDepthAddr(nCurDataRec), Entry, nSize);
+
+	return this->ConvertToMeter(ReadCode(Entry, nReprCode, nSize), dataFormatSpec.nDepthUnit);
+}
+
+///////////////////////////////////////////////////////////
+// Doc do sau cua tat ca Data Record trong [nDepthStartRec, nDepthEndRec]
+// va tao depthIndex tren [nStartDataRec, nEndDataRec]. Chi thuc hien lan dau (ket qua duoc giu den khi
+// dong file). Khong co memory mapping: cac record gan nhau (cach nhau
+// < LIS_DEPTHREAD_GAP) duoc gom vao mot lan doc <= LIS_DEPTHREAD_SPAN byte.
+///////////////////////////////////////////////////////////
+void CLisFile::ReadAllDepth()
+{
+	if(this->bDepthRead)
+		return;
+	this->bDepthRead = true;
+
+	CLisPerfScope	perfScope(perfStats, LIS_PHASE_DEPTH);
+
+	int		nReprCode = this->GetDepthReprCode();
+	int		nSize = GetCodeSize(nReprCode);
+	BYTE*	pSpan = NULL;
+
+	if(!mappedFile.IsOpen())
+		pSpan = new BYTE[LIS_DEPTHREAD_SPAN];
+
+	//Do sau da co trong file chi muc: khong doc lai
+	int		i = (this->bDepthLoaded ? nDepthEndRec + 1 : nDepthStartRec);
+	while(i <= nDepthEndRec)
+	{
+		if(lisRecordArr[i]->nType != 0)
+		{
+			i++;
+			continue;
+		}
+
+		if(pSpan == NULL)
+		{
+			lisRecordArr[i]->fDepth = this->ReadRecDepth(i);
+			i++;
+			continue;
+		}
+
+		long	lFirst = this->GetDepthAddr(i);
+		long	lLast = lFirst + nSize;
+		int		nLastRec = i;
+
+		for(int k = i+1; k<=nDepthEndRec; k++)
+		{
+			if(lisRecordArr[k]->nType != 0)
+				continue;
+
+			long	lAddr = this->GetDepthAddr(k);
+
+			if(lAddr < lLast || lAddr - lLast > LIS_DEPTHREAD_GAP ||
+				lAddr + nSize - lFirst > LIS_DEPTHREAD_SPAN)
+				break;
+
+			lLast = lAddr + nSize;
+			nLastRec = k;
+		}
+
+		this->ReadAt(lFirst, pSpan, lLast - lFirst);
+
+		for(int k = i; k<=nLastRec; k++)
+		{
+			if(lisRecordArr[k]->nType != 0)
+				continue;
+
+			float	fDepth = ReadCode(pSpan + (this->GetDepthAddr(k) - lFirst), nReprCode, nSize);
+			lisRecordArr[k]->fDepth = this->ConvertToMeter(fDepth, dataFormatSpec.nDepthUnit);
+		}
+		i = nLastRec + 1;
+	}
+
+	if(pSpan != NULL)
+		delete[] pSpan;
+
+	//Chi muc do sau: moi Data Record mot phan tu (do sau frame dau, so frame)
+	this->depthIndex.RemoveAll();
+	for(i = nStartDataRec; i<=nEndDataRec; i++)
+		if(lisRecordArr[i]->nType == 0)
+			this->depthIndex.Add(i, lisRecordArr[i]->fDepth, this->GetFrameNum(i));
+	this->depthIndex.Finish(this->lStep/1000.0);
+	perfScope.Stop();
+
+	if(this->bUseIndexCache && !this->bDepthLoaded)
+		this->SaveIndexCache();
+}
+
+//Do sau (m) cua Data Record nCurDataRec: doc do sau cua tat ca
+//Data Record (ReadAllDepth) o lan goi dau
+float CLisFile::GetRecDepth(int nCurDataRec)
+{
+	this->ReadAllDepth();
+	return lisRecordArr[nCurDataRec]->fDepth;
+}
+
+///////////////////////////////////////////////////////////
+// Khoang Data Record chua cac frame trong [fTop, fBottom] (m), tim
+// nhi phan tren depthIndex. fTop == fBottom: toan bo file.
+// Tra ve false neu khong co record nao trong khoang.
+///////////////////////////////////////////////////////////
+bool CLisFile::GetDataRecRange(float fTop, float fBottom, int& nFirstRec, int& nLastRec)
+{
+	nFirstRec = this->nStartDataRec;
+	nLastRec = this->nEndDataRec;
+
+	if(fTop == fBottom)
+		return true;
+
+	this->ReadAllDepth();
+	if(this->depthIndex.GetCount() == 0)
+		return true;
+
+	return this->depthIndex.FindRange(fTop, fBottom, nFirstRec, nLastRec);
 }
 void	CLisFile::GetStepList(float step[], int factor[], int&	nStepCount)
 {
@@ -10,9 +10,20 @@
 #endif // _MSC_VER > 1000
 
 #include "DatumSpecBlk.h"
+#include "LisMappedFile.h"
+#include "LisPipeline.h"
+#include "LisDepthIndex.h"
+#include "LisArena.h"
+#include "LisPerfStats.h"
 
 #define		FLWHEADER	2048
 
+#define		LIS_BYTEDATA_SIZE	150000//Kich thuoc bo dem byte cua mot Data Record
+#define		LIS_FILEDATA_SIZE	60000//So gia tri toi da cua mot Data Record
+#define		LIS_DEPTHREAD_GAP	4096//ReadAllDepth: khoang cach toi da giua hai record de gom chung mot lan doc
+#define		LIS_DEPTHREAD_SPAN	65536//ReadAllDepth: kich thuoc toi da cua mot lan doc
+#define		LIS_MAX_INTERNNAME	64//So ten record dung chung toi da (InternName)
+
 #define		DIR_UP		1
 #define		DIR_DOWN	255
 #define		DIR_NEITHER	0
@@ -47,6 +58,10 @@ public:
 	CBlankRecord();
 	virtual ~CBlankRecord();
 	CBlankRecord(long PrevAddr,long Addr,long NextAddr,long NextRecLen,int Num=0)
+	{
+		Init(PrevAddr,Addr,NextAddr,NextRecLen,Num);
+	}
+	void Init(long PrevAddr,long Addr,long NextAddr,long NextRecLen,int Num=0)
 	{
 		lPrevAddr=PrevAddr;
 		lNextAddr=NextAddr;
@@ -72,11 +87,15 @@ public:
 	int			nFrameNum;
 	//int			nStartFrame;
 	//int			nEndFrame;
-	float		fDepth;
+	float		fDepth;//Do sau (m): chi dung sau CLisFile::ReadAllDepth, nen doc qua CLisFile::GetRecDepth
 public:
 	CLisRecord();
 	virtual ~CLisRecord();
 	CLisRecord(int nType,long lAddr,long lLen,CString strName)
+	{
+		Init(nType,lAddr,lLen,strName);
+	}
+	void Init(int nType,long lAddr,long lLen,const CString& strName)
 	{
 		this->nType=nType;
 		this->lAddr=lAddr;
@@ -153,7 +172,12 @@ public:
 	CString				m_strDatFileName;
 
 	CBlankRecordArray	blankArr;
-	CLisRecordArray		lisRecordArr;
+	long				lBlankScanPos;//DetectFileType: vi tri Blank Record tiep theo trong blankArr
+	long				lBlankScanAddr;
+	CLisRecordArray		lisRecordArr;//fDepth cua Data Record doc lazy: dung GetRecDepth
+	CLisArena<CBlankRecord>	blankArena;//Bo nho cua cac phan tu blankArr
+	CLisArena<CLisRecord>	recordArena;//Bo nho cua cac phan tu lisRecordArr
+	CArray<CString>		nameArr;//Ten record dung chung
 	CDatumSpecBlkArray	datumArr;
 	CWellInfoArray		CONSArr;
 	CWellInfoArray		OUTPArr;
@@ -164,8 +188,12 @@ public:
 
 	DataFormatSpec_t	dataFormatSpec;
 
-	CFile				hFile;
+	CLisPerfFile		hFile;//Dem so lan Read/Seek vao perfStats
 	bool				bIsFileOpen;
+	bool				bUseMappedFile;//Doc file qua memory mapping
+	bool				bUseIndexCache;//Doc/ghi bang record va do sau qua file chi muc (.cidx)
+	bool				bIndexLoaded;//Bang record cua file hien tai lay tu file chi muc
+	CLisMappedFile		mappedFile;
 	int					nDataFSRIdx;//Data Format Specification Record Index;
 	int					nAK73Idx;
 	int					nCB3Idx;
@@ -181,9 +209,15 @@ public:
 
 	int					nStartDataRec;
 	int					nEndDataRec;
+	int					nDepthStartRec;//Khoang record doc do sau (ReadAllDepth): tat ca
+	int					nDepthEndRec;//Data Record, truoc khi ReadDepth thu hep khoang
 
 	int					nDepthCurveIdx;//in case depth in each frame
 
+	CLisDepthIndex		depthIndex;//Do sau -> Data Record (tao khi can trong ReadAllDepth)
+	bool				bDepthRead;//Da doc do sau cua tat ca Data Record
+	bool				bDepthLoaded;//fDepth cua cac Data Record lay tu file chi muc
+
 	float				fCurDepth;
 	int					nCurDataRec;
 
@@ -200,11 +234,48 @@ public:
 	///////////////////////////////////////////////
 	BYTE				*pByteData;
 	float				*fFileData;
+
+	///////////////////////////////////////////////
+	// Pipeline doc/giai ma/ghi cua WriteToDatFile
+	int					nDecodeThreadNum;//0: theo so CPU, 1: tuan tu (khong dung pipeline)
+	int					nPipelineDepth;
+	LISPipelineStats	pipelineStats;//Thong ke stall cua lan WriteToDatFile gan nhat
+	LISPerfStats		perfStats;//Thoi gian/I-O tung giai doan tu lan OpenLisFile gan nhat (bEnabled)
+	CLisPipeline		pipeline;
+	BYTE**				pSlotByteData;//Bo dem byte cua moi slot
+	const BYTE**		pSlotData;//Du lieu record cua moi slot (bo dem hoac vung anh xa)
+	float**				pSlotFileData;//Gia tri da giai ma cua moi slot
+	float*				pSlotDepth;
+	int*				pSlotRec;
+	int					nPipelineSlotNum;
+	int					nPipelineItem;//Thu tu record tiep theo lay tu pipeline
+	bool				bPipelineReverse;
+	bool				bShowErrors;//false khi pipeline chay: ReadCode khong hien thong bao tren worker thread
+	volatile LONG		nDecodeErrorNum;//So lan ReadCode gap ma khong ho tro trong pipeline (bao sau khi dung)
 	
 public:
 	void GetAllData(int nCurDataRec);
+	float ReadDataRec(int nCurDataRec, BYTE* pBuf, const BYTE*& pData);
+	void DecodeDataRec(int nCurDataRec, const BYTE* pData, float* pDst);
+	void CountDecoded(int nCurDataRec);
+	int DecodeDatum(int i, const BYTE* pData, float* pDst, int& nValueNum);
+	bool ReadDataRecRange(int nCurDataRec, int nOffset, BYTE* pDst, int nCount);
+	int ReadChannelSlice(int nDatum, int nCurDataRec, int nFrame, float* pDst);
+	int ReadChannelSlice(int nDatum, float fDepth, float* pDst);
+	bool StartPipeline(bool bReverse);
+	float* FetchDataRec(int nCurDataRec);
+	void StopPipeline();
+	void ReadAt(long lAddr, BYTE* pDst, int nCount);
 	void OpenLIS(CProgressCtrl& progress);
 	void OpenNTI(CProgressCtrl& progress);
+	void ReadLISRecordTable(CProgressCtrl& progress);
+	void ReadNTIRecordTable(CProgressCtrl& progress);
+	void DetectFileType();
+	bool LoadIndexCache();
+	bool SaveIndexCache();
+	CBlankRecord* NewBlankRecord(long lPrevAddr, long lAddr, long lNextAddr, long lNextRecLen, int nNum);
+	CLisRecord* NewLisRecord(int nType, long lAddr, long lLen, const CString& strName);
+	const CString& InternName(const CString& strName);
 
 	
 	
@@ -240,6 +311,12 @@ public:
 	void	ReadDataFormatSpecificationRecord();
 	void	ReadWellInfo(int idxTab, CWellInfoArray& arr);
 	void	ReadDepth();
+	void	ReadAllDepth();
+	long	GetDepthAddr(int nCurDataRec);
+	int		GetDepthReprCode();
+	float	ReadRecDepth(int nCurDataRec);
+	float	GetRecDepth(int nCurDataRec);
+	bool	GetDataRecRange(float fTop, float fBottom, int& nFirstRec, int& nLastRec);
 
 	void	GetStepList(float step[], int factor[], int&	nStepCount);
 };
@@ -0,0 +1,75 @@
+// LisFileType.cpp: implementation of the LISFileType class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisFileType.h"
+
+//////////////////////////////////////////////////////////////////////
+// Doc Blank Record tai pBlank (16 byte; 4 byte dau bo qua), cung cach
+// tinh voi CLisFile::ParseBlankRecord
+//////////////////////////////////////////////////////////////////////
+void LISFileType::ParseBlankRecord(const BYTE* pBlank, long& lPrevAddr, long& lNextAddr, long& lNextRecLen)
+{
+	const BYTE*	group2 = pBlank + 4;
+	const BYTE*	group3 = pBlank + 8;
+	const BYTE*	group4 = pBlank + 12;
+
+	long	l16x2=256;
+	long	l16x4=65536;
+	long	l16x6=16777216;
+
+	lPrevAddr=long(group2[0])+long(group2[1])*l16x2+
+				long(group2[2])*l16x4+long(group2[3])*l16x6;
+	lNextAddr=long(group3[0])+long(group3[1])*l16x2+
+				long(group3[2])*l16x4+long(group3[3])*l16x6;
+	lNextRecLen=long(group4[1])+long(group4[0])*l16x2;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Duyet chuoi Blank Record trong pPrefix (lPrefixLen byte dau cua file
+// lFileSize byte). Dung lai ngay khi gap lien ket sai (NTI) hoac khi
+// da co LIS_DETECT_LINKS lien ket dung (LIS), khong can duyet het file.
+//////////////////////////////////////////////////////////////////////
+int LISFileType::Detect(const BYTE* pPrefix, long lPrefixLen, __int64 lFileSize)
+{
+	long	lPos = 0;
+	long	lAddr = 0;
+	long	lPrevAddr, lNextAddr, lNextRecLen;
+	long	lLastAddr = 0;//lAddr cua Blank Record truoc
+	int		nLinkNum = 0;
+
+	if(lFileSize < 16)
+		return LIS_FORMAT_NTI;
+
+	while(1)
+	{
+		if(lPos + 16 > lPrefixLen)
+			return LIS_FORMAT_MORE;
+
+		ParseBlankRecord(pPrefix + lPos, lPrevAddr, lNextAddr, lNextRecLen);
+
+		//Blank Record dau tien (chi so 0) khong duoc kiem tra
+		if(nLinkNum >= 2 && lPrevAddr != lLastAddr)
+			return LIS_FORMAT_NTI;
+
+		nLinkNum++;
+		if(nLinkNum >= LIS_DETECT_LINKS)
+			return LIS_FORMAT_LIS;
+
+		if(lNextAddr < 0 || lNextAddr > lFileSize)
+			break;
+
+		lLastAddr = lAddr;
+		lAddr = lNextAddr;
+		lPos += 16 + lNextRecLen - 4;
+
+		if(lPos >= lFileSize-16)
+			break;
+	}
+
+	if(nLinkNum >= LIS_DETECT_MINLINKS)
+		return LIS_FORMAT_LIS;
+
+	return LIS_FORMAT_SHORT;
+}
@@ -0,0 +1,28 @@
+// LisFileType.h: interface for the LISFileType class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#define		LIS_DETECT_PREFIX		(256*1024)//So byte dau file dung de nhan dang
+#define		LIS_DETECT_LINKS		16//So Blank Record lien tiep hop le du de ket luan LIS
+#define		LIS_DETECT_MINLINKS		6//It hon: chuoi qua ngan, khong ket luan duoc
+
+//Ket qua LISFileType::Detect
+#define		LIS_FORMAT_LIS			1//Co chuoi Blank Record (Russia)
+#define		LIS_FORMAT_NTI			2//Khong co Blank Record (Halliburton)
+#define		LIS_FORMAT_SHORT		3//Chuoi Blank Record ket thuc truoc LIS_DETECT_MINLINKS
+#define		LIS_FORMAT_MORE			4//Can doc them (chuoi vuot qua phan dau file)
+
+//////////////////////////////////////////////////////////////////////
+// Nhan dang file LIS/NTI tu phan dau file: moi Blank Record (16 byte)
+// chua dia chi record truoc/sau va chieu dai record sau. File LIS co
+// chuoi Blank Record lien ket dung (lPrevAddr cua record sau = lAddr
+// cua record truoc). Dung chung cho CLisFile va LISFileClass.
+//////////////////////////////////////////////////////////////////////
+class LISFileType
+{
+public:
+	static int	Detect(const BYTE* pPrefix, long lPrefixLen, __int64 lFileSize);
+	static void	ParseBlankRecord(const BYTE* pBlank, long& lPrevAddr, long& lNextAddr, long& lNextRecLen);
+};
@@ -0,0 +1,267 @@
+// LisIndexCache.cpp: implementation of the CLisIndexCache class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisIndexCache.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+//Header cua mot section trong file: nTag, nElemSize, nCount, (du phong)
+#define		LIS_INDEXCACHE_SECTIONHDR	(4*sizeof(int))
+
+//Du lieu moi section duoc can le 8 byte trong file (va trong pBuf)
+static int AlignSectionSize(int nSize)
+{
+	return (nSize + 7) & ~7;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisIndexCache::CLisIndexCache()
+{
+	this->pBuf = NULL;
+	memset(&this->header, 0, sizeof(this->header));
+}
+
+CLisIndexCache::~CLisIndexCache()
+{
+	Clear();
+}
+
+void CLisIndexCache::Clear()
+{
+	if(this->pBuf != NULL)
+	{
+		delete[] this->pBuf;
+		this->pBuf = NULL;
+	}
+	this->sectionArr.RemoveAll();
+	memset(&this->header, 0, sizeof(this->header));
+}
+
+CString CLisIndexCache::GetIndexFileName(LPCTSTR lpszLisFile, int nOwner)
+{
+	CString		str = lpszLisFile;
+
+	if(nOwner == LIS_INDEXCACHE_LISFILECLASS)
+		str += ".lidx";
+	else
+		str += ".cidx";
+
+	return str;
+}
+
+///////////////////////////////////////////////////////////
+// Kich thuoc, thoi gian sua doi va hash LIS_INDEXCACHE_HASHSIZE
+// byte dau cua file LIS/NTI
+///////////////////////////////////////////////////////////
+bool CLisIndexCache::GetFileStamp(LPCTSTR lpszLisFile, LISIndexCacheHeader& stamp)
+{
+	struct _stati64	st;
+
+	memset(&stamp, 0, sizeof(stamp));
+
+	if(_stati64(lpszLisFile, &st) != 0)
+		return false;
+
+	stamp.nFileSize = (__int64)st.st_size;
+	stamp.nModTime = (__int64)st.st_mtime;
+
+	FILE*	hLis = fopen(lpszLisFile, "rb");
+	if(hLis == NULL)
+		return false;
+
+	BYTE*	pHead = new BYTE[LIS_INDEXCACHE_HASHSIZE];
+	int		nRead = (int)fread(pHead, sizeof(BYTE), LIS_INDEXCACHE_HASHSIZE, hLis);
+	DWORD	nHash = 2166136261u;
+
+	fclose(hLis);
+
+	for(int i = 0; i<nRead; i++)
+	{
+		nHash ^= pHead[i];
+		nHash *= 16777619u;
+	}
+	delete[] pHead;
+
+	stamp.nHeaderHash = nHash;
+	return true;
+}
+
+///////////////////////////////////////////////////////////
+// Doc file chi muc cua lpszLisFile. Tra ve false neu khong co file,
+// file hong hoac khong con khop voi file LIS (da bi sua/ghi de).
+///////////////////////////////////////////////////////////
+bool CLisIndexCache::Load(LPCTSTR lpszLisFile, int nOwner)
+{
+	Clear();
+
+	LISIndexCacheHeader		stamp;
+
+	if(!GetFileStamp(lpszLisFile, stamp))
+		return false;
+
+	FILE*	hIdx = fopen(GetIndexFileName(lpszLisFile, nOwner), "rb");
+	if(hIdx == NULL)
+		return false;
+
+	fseek(hIdx, 0L, SEEK_END);
+	long	lSize = ftell(hIdx) - (long)sizeof(this->header);
+	fseek(hIdx, 0L, SEEK_SET);
+
+	bool	bOK = (lSize >= 0 &&
+		fread(&this->header, sizeof(this->header), 1, hIdx) == 1);
+
+	if(bOK)
+		bOK = (this->header.nMagic == LIS_INDEXCACHE_MAGIC &&
+			this->header.nVersion == LIS_INDEXCACHE_VERSION &&
+			this->header.nOwner == nOwner &&
+			this->header.nFileSize == stamp.nFileSize &&
+			this->header.nModTime == stamp.nModTime &&
+			this->header.nHeaderHash == stamp.nHeaderHash &&
+			this->header.nSectionNum >= 0);
+
+	if(bOK)
+	{
+		this->pBuf = new BYTE[lSize + 1];
+		bOK = ((long)fread(this->pBuf, sizeof(BYTE), lSize, hIdx) == lSize);
+	}
+	fclose(hIdx);
+
+	//Danh sach section (kiem tra kich thuoc tung section)
+	long	lPos = 0;
+
+	for(int i = 0; bOK && i<this->header.nSectionNum; i++)
+	{
+		int		nSectionHdr[4];
+
+		if(lPos + (long)LIS_INDEXCACHE_SECTIONHDR > lSize)
+		{
+			bOK = false;
+			break;
+		}
+		memcpy(nSectionHdr, this->pBuf + lPos, LIS_INDEXCACHE_SECTIONHDR);
+		lPos += LIS_INDEXCACHE_SECTIONHDR;
+
+		LISIndexCacheSection	section;
+
+		section.nTag = nSectionHdr[0];
+		section.nElemSize = nSectionHdr[1];
+		section.nCount = nSectionHdr[2];
+		section.pData = this->pBuf + lPos;
+
+		if(section.nElemSize <= 0 || section.nCount < 0 ||
+			(double)section.nElemSize*section.nCount > (double)(lSize - lPos))
+		{
+			bOK = false;
+			break;
+		}
+		lPos += AlignSectionSize(section.nElemSize*section.nCount);
+
+		this->sectionArr.Add(section);
+	}
+
+	if(!bOK)
+	{
+		Clear();
+		return false;
+	}
+
+	return true;
+}
+
+//Section nTag voi phan tu nElemSize byte, NULL neu khong co (hoac khac kich thuoc)
+const void* CLisIndexCache::GetSection(int nTag, int nElemSize, int& nCount) const
+{
+	nCount = 0;
+
+	for(int i = 0; i<this->sectionArr.GetSize(); i++)
+	{
+		const LISIndexCacheSection&	section = this->sectionArr[i];
+
+		if(section.nTag != nTag)
+			continue;
+		if(section.nElemSize != nElemSize)
+			return NULL;
+
+		nCount = section.nCount;
+		return section.pData;
+	}
+
+	return NULL;
+}
+
+void CLisIndexCache::AddSection(int nTag, const void* pData, int nElemSize, int nCount)
+{
+	LISIndexCacheSection	section;
+
+	section.nTag = nTag;
+	section.nElemSize = nElemSize;
+	section.nCount = nCount;
+	section.pData = pData;
+
+	this->sectionArr.Add(section);
+}
+
+///////////////////////////////////////////////////////////
+// Ghi cac section da them (AddSection) ra file chi muc. Ghi vao file
+// tam roi doi ten, de lan mo khac khong doc phai file ghi do dang.
+///////////////////////////////////////////////////////////
+bool CLisIndexCache::Save(LPCTSTR lpszLisFile, int nOwner)
+{
+	LISIndexCacheHeader		stamp;
+
+	if(!GetFileStamp(lpszLisFile, stamp))
+		return false;
+
+	stamp.nMagic = LIS_INDEXCACHE_MAGIC;
+	stamp.nVersion = LIS_INDEXCACHE_VERSION;
+	stamp.nOwner = nOwner;
+	stamp.nSectionNum = (int)this->sectionArr.GetSize();
+
+	CString		strIdxFile = GetIndexFileName(lpszLisFile, nOwner);
+	CString		strTmpFile = strIdxFile + ".tmp";
+
+	FILE*	hIdx = fopen(strTmpFile, "wb");
+	if(hIdx == NULL)
+		return false;
+
+	BYTE	pad[8];
+	bool	bOK = (fwrite(&stamp, sizeof(stamp), 1, hIdx) == 1);
+
+	memset(pad, 0, sizeof(pad));
+
+	for(int i = 0; bOK && i<this->sectionArr.GetSize(); i++)
+	{
+		const LISIndexCacheSection&	section = this->sectionArr[i];
+		int		nSectionHdr[4];
+		int		nSize = section.nElemSize*section.nCount;
+
+		nSectionHdr[0] = section.nTag;
+		nSectionHdr[1] = section.nElemSize;
+		nSectionHdr[2] = section.nCount;
+		nSectionHdr[3] = 0;
+
+		bOK = (fwrite(nSectionHdr, LIS_INDEXCACHE_SECTIONHDR, 1, hIdx) == 1);
+		if(bOK && nSize > 0)
+			bOK = (fwrite(section.pData, nSize, 1, hIdx) == 1);
+		if(bOK && AlignSectionSize(nSize) > nSize)
+			bOK = (fwrite(pad, AlignSectionSize(nSize) - nSize, 1, hIdx) == 1);
+	}
+
+	if(fclose(hIdx) != 0)
+		bOK = false;
+
+	if(bOK)
+	{
+		remove(strIdxFile);
+		bOK = (rename(strTmpFile, strIdxFile) == 0);
+	}
+	if(!bOK)
+		remove(strTmpFile);
+
+	return bOK;
+}
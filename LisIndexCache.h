@@ -0,0 +1,65 @@
+// LisIndexCache.h: interface for the CLisIndexCache class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#define		LIS_INDEXCACHE_MAGIC		0x5849534C//"LISX"
+#define		LIS_INDEXCACHE_VERSION		4//Tang moi khi doi header hoac dinh dang mot section
+#define		LIS_INDEXCACHE_HASHSIZE		65536//So byte dau file LIS dung de tinh hash
+
+#define		LIS_INDEXCACHE_LISFILECLASS	1//File chi muc cua LISFileClass (.lidx)
+#define		LIS_INDEXCACHE_CLISFILE		2//File chi muc cua CLisFile (.cidx)
+
+//Dau hieu nhan dang file LIS/NTI: file chi muc chi dung duoc khi trung khop
+class LISIndexCacheHeader
+{
+public:
+	DWORD	nMagic;
+	int		nVersion;
+	int		nOwner;
+	__int64	nFileSize;//_stati64: dung cho file > 2 GB
+	__int64	nModTime;
+	DWORD	nHeaderHash;//FNV-1a cua LIS_INDEXCACHE_HASHSIZE byte dau
+	int		nSectionNum;
+};
+
+//Mot mang phan tu kich thuoc co dinh, nhan dang bang nTag
+class LISIndexCacheSection
+{
+public:
+	int			nTag;
+	int			nElemSize;
+	int			nCount;
+	const void*	pData;
+};
+
+//////////////////////////////////////////////////////////////////////
+// File chi muc dat canh file LIS/NTI (sidecar index): luu ket qua quet
+// file (bang record, do sau...) de lan mo sau khong phai quet lai.
+// Noi dung la cac section (mang phan tu), kiem tra bang kich thuoc,
+// thoi gian sua doi va hash phan dau cua file LIS. Moi loi doc/ghi
+// deu bo qua (Load tra ve false: quet file nhu binh thuong).
+//////////////////////////////////////////////////////////////////////
+class CLisIndexCache
+{
+public:
+	LISIndexCacheHeader				header;
+	CArray<LISIndexCacheSection>	sectionArr;
+	BYTE*							pBuf;//Noi dung file chi muc da doc (Load)
+public:
+	CLisIndexCache();
+	~CLisIndexCache();
+
+	void		Clear();
+
+	bool		Load(LPCTSTR lpszLisFile, int nOwner);
+	const void*	GetSection(int nTag, int nElemSize, int& nCount) const;
+
+	//pData phai con hop le den khi goi Save
+	void		AddSection(int nTag, const void* pData, int nElemSize, int nCount);
+	bool		Save(LPCTSTR lpszLisFile, int nOwner);
+
+	static CString	GetIndexFileName(LPCTSTR lpszLisFile, int nOwner);
+	static bool		GetFileStamp(LPCTSTR lpszLisFile, LISIndexCacheHeader& stamp);
+};
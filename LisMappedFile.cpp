@@ -0,0 +1,102 @@
+// LisMappedFile.cpp: implementation of the CLisMappedFile class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisMappedFile.h"
+#include "LisPerfStats.h"
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisMappedFile::CLisMappedFile()
+{
+	this->hFile = INVALID_HANDLE_VALUE;
+	this->hMapping = NULL;
+	this->pView = NULL;
+	this->lLength = 0;
+	this->pPerfStats = NULL;
+}
+
+CLisMappedFile::~CLisMappedFile()
+{
+	Close();
+}
+
+bool CLisMappedFile::Open(LPCTSTR lpszFileName)
+{
+	Close();
+
+	this->hFile = CreateFile(lpszFileName, GENERIC_READ, FILE_SHARE_READ,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(this->hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	//Chi anh xa file < 2GB (dia chi record duoc luu bang long)
+	DWORD	dwSizeHigh = 0;
+	DWORD	dwSizeLow = GetFileSize(this->hFile, &dwSizeHigh);
+	if(dwSizeHigh != 0 || dwSizeLow == 0 || dwSizeLow > 0x7FFFFFFF)
+	{
+		Close();
+		return false;
+	}
+
+	this->hMapping = CreateFileMapping(this->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(this->hMapping == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	this->pView = (const BYTE*)MapViewOfFile(this->hMapping, FILE_MAP_READ, 0, 0, 0);
+	if(this->pView == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	this->lLength = (long)dwSizeLow;
+	return true;
+}
+
+void CLisMappedFile::Close()
+{
+	if(this->pView != NULL)
+	{
+		UnmapViewOfFile(this->pView);
+		this->pView = NULL;
+	}
+	if(this->hMapping != NULL)
+	{
+		CloseHandle(this->hMapping);
+		this->hMapping = NULL;
+	}
+	if(this->hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(this->hFile);
+		this->hFile = INVALID_HANDLE_VALUE;
+	}
+	this->lLength = 0;
+}
+
+//Copy nCount byte tu vi tri lAddr. Phan nam ngoai file duoc dien 0.
+int CLisMappedFile::Read(long lAddr, BYTE* pDst, int nCount) const
+{
+	int		nCopy = 0;
+
+	if(lAddr >= 0 && lAddr < this->lLength)
+	{
+		nCopy = nCount;
+		if(nCopy > this->lLength - lAddr)
+			nCopy = (int)(this->lLength - lAddr);
+		memcpy(pDst, this->pView + lAddr, nCopy);
+	}
+	if(nCopy < nCount)
+		memset(pDst + nCopy, 0, nCount - nCopy);
+
+	if(this->pPerfStats != NULL)
+		this->pPerfStats->AddRead(nCopy);
+
+	return nCopy;
+}
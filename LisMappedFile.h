@@ -0,0 +1,37 @@
+// LisMappedFile.h: interface for the CLisMappedFile class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+class LISPerfStats;
+
+//////////////////////////////////////////////////////////////////////
+// Anh xa toan bo file LIS/NTI vao bo nho (read-only memory mapping).
+// Header va du lieu cua record duoc doc truc tiep tu vung anh xa,
+// khong can Seek/Read cho tung record.
+//////////////////////////////////////////////////////////////////////
+class CLisMappedFile
+{
+public:
+	HANDLE			hFile;
+	HANDLE			hMapping;
+	const BYTE*		pView;
+	long			lLength;
+	LISPerfStats*	pPerfStats;//!= NULL: dem so lan/so byte Read
+public:
+	CLisMappedFile();
+	~CLisMappedFile();
+
+	bool			Open(LPCTSTR lpszFileName);
+	void			Close();
+
+	bool			IsOpen() const		{ return (pView != NULL); }
+	const BYTE*		GetPtr(long lAddr) const	{ return pView + lAddr; }
+	bool			Contains(long lAddr, long lCount) const
+	{
+		return (lAddr >= 0 && lCount >= 0 && lAddr <= lLength - lCount);
+	}
+
+	int				Read(long lAddr, BYTE* pDst, int nCount) const;
+};
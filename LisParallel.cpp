@@ -0,0 +1,110 @@
+// LisParallel.cpp: implementation of the LISParallel class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisParallel.h"
+#include <process.h>
+
+class LISParallelJob
+{
+public:
+	LISParallelProc	pProc;
+	void*			pParam;
+	int				nCount;
+
+	volatile LONG	nNext;//Chi so viec tiep theo
+	volatile LONG	nDone;//So viec da xong
+};
+
+static unsigned __stdcall LISParallelThreadProc(void* pArg)
+{
+	LISParallelJob*	pJob = (LISParallelJob*)pArg;
+	int				nIdx;
+
+	while((nIdx = (int)InterlockedIncrement(&pJob->nNext) - 1) < pJob->nCount)
+	{
+		pJob->pProc(nIdx, pJob->pParam);
+		InterlockedIncrement(&pJob->nDone);
+	}
+
+	return 0;
+}
+
+int LISParallel::GetProcessorNum()
+{
+	SYSTEM_INFO		sysInfo;
+
+	GetSystemInfo(&sysInfo);
+	if(sysInfo.dwNumberOfProcessors < 1)
+		return 1;
+
+	return (int)sysInfo.dwNumberOfProcessors;
+}
+
+void LISParallel::For(int nCount, LISParallelProc pProc, void* pParam,
+					  int nThreadNum, CProgressCtrl* pProgress)
+{
+	if(nCount <= 0) return;
+
+	if(nThreadNum <= 0)
+		nThreadNum = GetProcessorNum();
+	if(nThreadNum > nCount)
+		nThreadNum = nCount;
+	if(nThreadNum > MAXIMUM_WAIT_OBJECTS)
+		nThreadNum = MAXIMUM_WAIT_OBJECTS;
+
+	if(pProgress != NULL)
+	{
+		pProgress->SetRange(0, nCount);
+		pProgress->SetPos(0);
+	}
+
+	LISParallelJob	job;
+
+	job.pProc = pProc;
+	job.pParam = pParam;
+	job.nCount = nCount;
+	job.nNext = 0;
+	job.nDone = 0;
+
+	//Mot thread: chay ngay tren thread goi ham
+	if(nThreadNum <= 1)
+	{
+		for(int i = 0; i < nCount; i++)
+		{
+			pProc(i, pParam);
+			if(pProgress != NULL)
+				pProgress->SetPos(i + 1);
+		}
+		return;
+	}
+
+	HANDLE*		hThreadArr = new HANDLE[nThreadNum];
+	int			nStarted = 0;
+
+	for(int i = 0; i < nThreadNum; i++)
+	{
+		hThreadArr[nStarted] = (HANDLE)_beginthreadex(NULL, 0, LISParallelThreadProc, &job, 0, NULL);
+		if(hThreadArr[nStarted] != 0)
+			nStarted++;
+	}
+
+	//Khong tao duoc thread nao: lam tren thread hien tai
+	if(nStarted == 0)
+		LISParallelThreadProc(&job);
+
+	while(nStarted > 0 &&
+		WaitForMultipleObjects(nStarted, hThreadArr, TRUE, 100) == WAIT_TIMEOUT)
+	{
+		if(pProgress != NULL)
+			pProgress->SetPos((int)job.nDone);
+	}
+
+	for(int i = 0; i < nStarted; i++)
+		CloseHandle(hThreadArr[i]);
+	delete[] hThreadArr;
+
+	if(pProgress != NULL)
+		pProgress->SetPos(nCount);
+}
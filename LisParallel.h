@@ -0,0 +1,23 @@
+// LisParallel.h: interface for the LISParallel class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+typedef void (*LISParallelProc)(int nIdx, void* pParam);
+
+//////////////////////////////////////////////////////////////////////
+// Chay pProc(0..nCount-1) tren nhieu thread (thread pool don gian).
+// Moi thread lay chi so tiep theo bang InterlockedIncrement cho den
+// khi het viec. Thread goi ham cho tat ca ket thuc va cap nhat
+// pProgress (neu co) theo so viec da xong.
+//////////////////////////////////////////////////////////////////////
+class LISParallel
+{
+public:
+	static int	GetProcessorNum();
+
+	//nThreadNum <= 0: dung so CPU
+	static void	For(int nCount, LISParallelProc pProc, void* pParam,
+					int nThreadNum = 0, CProgressCtrl* pProgress = NULL);
+};
@@ -0,0 +1,126 @@
+// LisPerfStats.cpp: implementation of the LISPerfStats class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisPerfStats.h"
+
+//Thoi gian CPU (user + kernel) cua process, don vi 100 ns
+static LONGLONG GetProcessCPUTime()
+{
+	FILETIME	ftCreation, ftExit, ftKernel, ftUser;
+
+	if(!GetProcessTimes(GetCurrentProcess(), &ftCreation, &ftExit, &ftKernel, &ftUser))
+		return 0;
+
+	return (((LONGLONG)ftKernel.dwHighDateTime << 32) | ftKernel.dwLowDateTime) +
+		(((LONGLONG)ftUser.dwHighDateTime << 32) | ftUser.dwLowDateTime);
+}
+
+static LONGLONG GetWallTicks()
+{
+	LARGE_INTEGER	count;
+
+	QueryPerformanceCounter(&count);
+	return count.QuadPart;
+}
+
+//////////////////////////////////////////////////////////////////////
+// LISPerfStats
+//////////////////////////////////////////////////////////////////////
+
+void LISPerfStats::Reset()
+{
+	for(int i = 0; i<LIS_PHASE_NUM; i++)
+	{
+		this->fWallTime[i] = 0;
+		this->fCPUTime[i] = 0;
+	}
+	this->nBytesRead = 0;
+	this->nReadCalls = 0;
+	this->nSeekCalls = 0;
+	this->nRecords = 0;
+	this->nFrames = 0;
+	this->nValues = 0;
+}
+
+//Cong cac bo dem cua stats (vi du cua mot Logical File chuyen doi tren
+//thread khac). Thoi gian khong cong: cac lan do chay dong thoi.
+void LISPerfStats::AddCounters(const LISPerfStats& stats)
+{
+	this->nBytesRead += stats.nBytesRead;
+	this->nReadCalls += stats.nReadCalls;
+	this->nSeekCalls += stats.nSeekCalls;
+	this->nRecords += stats.nRecords;
+	this->nFrames += stats.nFrames;
+	this->nValues += stats.nValues;
+}
+
+const char* LISPerfStats::GetPhaseName(int nPhase)
+{
+	switch(nPhase)
+	{
+	case LIS_PHASE_DETECT:	return "Detect";
+	case LIS_PHASE_INDEX:	return "Index";
+	case LIS_PHASE_DFSR:	return "DFSR";
+	case LIS_PHASE_DEPTH:	return "Depth scan";
+	case LIS_PHASE_READ:	return "Read";
+	case LIS_PHASE_DECODE:	return "Decode";
+	case LIS_PHASE_WRITE:	return "Write";
+	case LIS_PHASE_REVERSE:	return "UP reversal";
+	}
+	return "";
+}
+
+//Bang thoi gian tung giai doan va cac bo dem
+CString LISPerfStats::GetReport() const
+{
+	CString		strReport;
+	CString		str;
+
+	str.Format("%-12s %10s %10s\r\n", "Phase", "Wall (s)", "CPU (s)");
+	strReport += str;
+
+	for(int i = 0; i<LIS_PHASE_NUM; i++)
+	{
+		str.Format("%-12s %10.4f %10.4f\r\n", GetPhaseName(i), this->fWallTime[i], this->fCPUTime[i]);
+		strReport += str;
+	}
+
+	str.Format("Bytes read %.0f, read calls %.0f, seek calls %.0f\r\n",
+		(double)this->nBytesRead, (double)this->nReadCalls, (double)this->nSeekCalls);
+	strReport += str;
+	str.Format("Records %.0f, frames %.0f, values %.0f\r\n",
+		(double)this->nRecords, (double)this->nFrames, (double)this->nValues);
+	strReport += str;
+
+	return strReport;
+}
+
+//////////////////////////////////////////////////////////////////////
+// CLisPerfScope
+//////////////////////////////////////////////////////////////////////
+
+void CLisPerfScope::Start(LISPerfStats& stats, int nPhase)
+{
+	this->pStats = &stats;
+	this->nPhase = nPhase;
+	this->nStartCPU = GetProcessCPUTime();
+	this->nStartWall = GetWallTicks();
+}
+
+void CLisPerfScope::Stop()
+{
+	if(this->pStats == NULL)
+		return;
+
+	LONGLONG		nWall = GetWallTicks() - this->nStartWall;
+	LONGLONG		nCPU = GetProcessCPUTime() - this->nStartCPU;
+	LARGE_INTEGER	freq;
+
+	QueryPerformanceFrequency(&freq);
+
+	this->pStats->fWallTime[this->nPhase] += (double)nWall/(double)freq.QuadPart;
+	this->pStats->fCPUTime[this->nPhase] += (double)nCPU*1e-7;
+	this->pStats = NULL;
+}
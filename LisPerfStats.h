@@ -0,0 +1,138 @@
+// LisPerfStats.h: interface for the LISPerfStats class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//Cac giai doan duoc do thoi gian
+#define		LIS_PHASE_DETECT		0//Nhan dang loai file
+#define		LIS_PHASE_INDEX			1//Bang record/LR/PR, Logical File, file chi muc
+#define		LIS_PHASE_DFSR			2//Doc DFSR, tao Dataset va frame plan
+#define		LIS_PHASE_DEPTH			3//Doc do sau cac Data Record
+#define		LIS_PHASE_READ			4//Doc du lieu Data Record de giai ma
+#define		LIS_PHASE_DECODE		5
+#define		LIS_PHASE_WRITE			6//Ghi file DAT/file cot
+#define		LIS_PHASE_REVERSE		7//Dao nguoc cac dong cua file DAT (huong UP)
+#define		LIS_PHASE_NUM			8
+
+//////////////////////////////////////////////////////////////////////
+// Thoi gian va so lan I/O cua mot lan doc/chuyen doi file. Mac dinh tat
+// (bEnabled = false): khi tat, moi diem do chi kiem tra bEnabled.
+//
+// Thoi gian (giay) do tren thread goi ham. Thoi gian CPU la cua ca
+// process, nen khi giai ma tren nhieu thread (pipeline, giai ma song
+// song) thoi gian CPU cua LIS_PHASE_DECODE gom ca cac thread giai ma;
+// khi do viec doc du lieu cung tinh vao LIS_PHASE_DECODE.
+//
+// nBytesRead: byte lay tu file (fread/CFile::Read, copy tu vung anh xa
+// hoac dung thang vung anh xa); nReadCalls/nSeekCalls: so lan goi doc
+// (ke ca copy tu vung anh xa) va fseek/Seek.
+//
+// AddRead/AddSeek/AddDecoded cong nguyen tu: thread doc cua pipeline
+// goi chung dong thoi voi thread goi ham. CLisPerfScope chi dung tren
+// thread goi ham.
+//////////////////////////////////////////////////////////////////////
+class LISPerfStats
+{
+public:
+	bool		bEnabled;
+	double		fWallTime[LIS_PHASE_NUM];
+	double		fCPUTime[LIS_PHASE_NUM];
+	LONGLONG	nBytesRead;
+	LONGLONG	nReadCalls;
+	LONGLONG	nSeekCalls;
+	LONGLONG	nRecords;//So Data Record da giai ma
+	LONGLONG	nFrames;
+	LONGLONG	nValues;//So gia tri da giai ma
+public:
+	LISPerfStats()
+	{
+		this->bEnabled = false;
+		Reset();
+	}
+
+	void	Reset();//Xoa cac so do, giu bEnabled
+	void	AddCounters(const LISPerfStats& stats);
+	CString	GetReport() const;
+
+	void	AddRead(LONGLONG nBytes, int nCallNum = 1)
+	{
+		if(!this->bEnabled)
+			return;
+		InterlockedExchangeAdd64(&this->nBytesRead, nBytes);
+		InterlockedExchangeAdd64(&this->nReadCalls, nCallNum);
+	}
+	void	AddSeek()
+	{
+		if(this->bEnabled)
+			InterlockedIncrement64(&this->nSeekCalls);
+	}
+	void	AddDecoded(int nRecNum, int nFrameNum, LONGLONG nValueNum)
+	{
+		if(!this->bEnabled)
+			return;
+		InterlockedExchangeAdd64(&this->nRecords, nRecNum);
+		InterlockedExchangeAdd64(&this->nFrames, nFrameNum);
+		InterlockedExchangeAdd64(&this->nValues, nValueNum);
+	}
+
+	static const char*	GetPhaseName(int nPhase);
+};
+
+//////////////////////////////////////////////////////////////////////
+// Do mot giai doan tu luc tao doi tuong den Stop() (hoac den khi ra
+// khoi pham vi), cong vao stats.fWallTime/fCPUTime[nPhase].
+//////////////////////////////////////////////////////////////////////
+class CLisPerfScope
+{
+protected:
+	LISPerfStats*	pStats;//NULL: khong do
+	int				nPhase;
+	LONGLONG		nStartWall;
+	LONGLONG		nStartCPU;
+public:
+	CLisPerfScope(LISPerfStats& stats, int nPhase)
+	{
+		this->pStats = NULL;
+		if(stats.bEnabled)
+			Start(stats, nPhase);
+	}
+	~CLisPerfScope()
+	{
+		if(this->pStats != NULL)
+			Stop();
+	}
+
+	void	Stop();
+protected:
+	void	Start(LISPerfStats& stats, int nPhase);
+};
+
+//////////////////////////////////////////////////////////////////////
+// CFile dem so lan Read/Seek vao pPerfStats (CLisFile::hFile)
+//////////////////////////////////////////////////////////////////////
+class CLisPerfFile : public CFile
+{
+public:
+	LISPerfStats*	pPerfStats;
+public:
+	CLisPerfFile()
+	{
+		this->pPerfStats = NULL;
+	}
+
+	virtual UINT Read(void* lpBuf, UINT nCount)
+	{
+		UINT	nRead = CFile::Read(lpBuf, nCount);
+
+		if(this->pPerfStats != NULL)
+			this->pPerfStats->AddRead(nRead);
+		return nRead;
+	}
+	virtual ULONGLONG Seek(LONGLONG lOff, UINT nFrom)
+	{
+		if(this->pPerfStats != NULL)
+			this->pPerfStats->AddSeek();
+		return CFile::Seek(lOff, nFrom);
+	}
+};
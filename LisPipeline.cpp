@@ -0,0 +1,215 @@
+// LisPipeline.cpp: implementation of the CLisPipeline class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisPipeline.h"
+#include "LisParallel.h"
+#include <process.h>
+
+#define		LIS_PIPELINE_MAXDECODER		32
+
+//Cho h; neu phai cho (khong san sang ngay) thi tang bo dem stall va thoi gian cho
+static void LISPipelineWait(HANDLE h, LONG* pStall, LONG* pWait)
+{
+	if(WaitForSingleObject(h, 0) == WAIT_OBJECT_0)
+		return;
+
+	DWORD	dwStart = GetTickCount();
+
+	InterlockedIncrement(pStall);
+	WaitForSingleObject(h, INFINITE);
+	InterlockedExchangeAdd(pWait, (LONG)(GetTickCount() - dwStart));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////
+
+CLisPipeline::CLisPipeline()
+{
+	this->pReadProc = NULL;
+	this->pDecodeProc = NULL;
+	this->pParam = NULL;
+	this->nItemNum = 0;
+	this->nDepth = 0;
+	this->nDecoderNum = 0;
+
+	this->hFreeSem = NULL;
+	this->hReadSem = NULL;
+	this->hDoneEventArr = NULL;
+	this->hThreadArr = NULL;
+	this->nThreadNum = 0;
+
+	this->nNextDecode = 0;
+	this->bAbort = 0;
+}
+
+CLisPipeline::~CLisPipeline()
+{
+	Stop();
+}
+
+bool CLisPipeline::Start(int nItemNum, LISPipelineProc pReadProc, LISPipelineProc pDecodeProc, void* pParam,
+						 int nDepth, int nDecoderNum)
+{
+	Stop();
+
+	if(nItemNum <= 0 || nDepth <= 0)
+		return false;
+
+	if(nDecoderNum <= 0)
+		nDecoderNum = LISParallel::GetProcessorNum();
+	if(nDecoderNum > LIS_PIPELINE_MAXDECODER)
+		nDecoderNum = LIS_PIPELINE_MAXDECODER;
+
+	this->pReadProc = pReadProc;
+	this->pDecodeProc = pDecodeProc;
+	this->pParam = pParam;
+	this->nItemNum = nItemNum;
+	this->nDepth = nDepth;
+	this->nDecoderNum = nDecoderNum;
+	this->nNextDecode = 0;
+	this->bAbort = 0;
+
+	this->stats.Init();
+	this->stats.nItemNum = nItemNum;
+	this->stats.nDecoderNum = nDecoderNum;
+	this->stats.nDepth = nDepth;
+
+	this->hFreeSem = CreateSemaphore(NULL, nDepth, 0x7FFFFFFF, NULL);
+	this->hReadSem = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+	this->hDoneEventArr = new HANDLE[nDepth];
+	for(int i = 0; i < nDepth; i++)
+		this->hDoneEventArr[i] = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	this->hThreadArr = new HANDLE[nDecoderNum + 1];
+	this->nThreadNum = 0;
+
+	this->hThreadArr[this->nThreadNum] = (HANDLE)_beginthreadex(NULL, 0, ReadThreadProc, this, 0, NULL);
+	if(this->hThreadArr[this->nThreadNum] == 0)
+	{
+		Stop();
+		return false;
+	}
+	this->nThreadNum++;
+
+	for(int i = 0; i < nDecoderNum; i++)
+	{
+		this->hThreadArr[this->nThreadNum] = (HANDLE)_beginthreadex(NULL, 0, DecodeThreadProc, this, 0, NULL);
+		if(this->hThreadArr[this->nThreadNum] == 0)
+			break;
+		this->nThreadNum++;
+	}
+
+	//Khong tao duoc thread giai ma nao
+	if(this->nThreadNum == 1)
+	{
+		Stop();
+		return false;
+	}
+
+	return true;
+}
+
+//Cho record nItem giai ma xong (goi theo thu tu 0, 1, 2...), tra ve slot
+int CLisPipeline::WaitItem(int nItem)
+{
+	int		nSlot = nItem % this->nDepth;
+
+	LISPipelineWait(this->hDoneEventArr[nSlot], &this->stats.nWriteStall, &this->stats.lWriteWait);
+
+	return nSlot;
+}
+
+//Tra slot cua record nItem cho thread doc
+void CLisPipeline::ReleaseItem(int nItem)
+{
+	ReleaseSemaphore(this->hFreeSem, 1, NULL);
+}
+
+//Dung cac thread (ke ca khi chua lay het record) va giai phong tai nguyen
+void CLisPipeline::Stop()
+{
+	if(this->hThreadArr != NULL)
+	{
+		InterlockedExchange(&this->bAbort, 1);
+		ReleaseSemaphore(this->hFreeSem, this->nDepth, NULL);
+		ReleaseSemaphore(this->hReadSem, this->nDecoderNum, NULL);
+
+		for(int i = 0; i < this->nThreadNum; i++)
+		{
+			WaitForSingleObject(this->hThreadArr[i], INFINITE);
+			CloseHandle(this->hThreadArr[i]);
+		}
+
+		delete[] this->hThreadArr;
+		this->hThreadArr = NULL;
+		this->nThreadNum = 0;
+	}
+
+	if(this->hDoneEventArr != NULL)
+	{
+		for(int i = 0; i < this->nDepth; i++)
+			CloseHandle(this->hDoneEventArr[i]);
+
+		delete[] this->hDoneEventArr;
+		this->hDoneEventArr = NULL;
+	}
+
+	if(this->hFreeSem != NULL)
+	{
+		CloseHandle(this->hFreeSem);
+		this->hFreeSem = NULL;
+	}
+	if(this->hReadSem != NULL)
+	{
+		CloseHandle(this->hReadSem);
+		this->hReadSem = NULL;
+	}
+}
+
+unsigned __stdcall CLisPipeline::ReadThreadProc(void* pArg)
+{
+	((CLisPipeline*)pArg)->ReadLoop();
+	return 0;
+}
+
+unsigned __stdcall CLisPipeline::DecodeThreadProc(void* pArg)
+{
+	((CLisPipeline*)pArg)->DecodeLoop();
+	return 0;
+}
+
+void CLisPipeline::ReadLoop()
+{
+	for(int nItem = 0; nItem < this->nItemNum; nItem++)
+	{
+		LISPipelineWait(this->hFreeSem, &this->stats.nReadStall, &this->stats.lReadWait);
+		if(this->bAbort)
+			break;
+
+		this->pReadProc(nItem, nItem % this->nDepth, this->pParam);
+		ReleaseSemaphore(this->hReadSem, 1, NULL);
+	}
+
+	//Moi thread giai ma nhan mot lan bao ket thuc
+	ReleaseSemaphore(this->hReadSem, this->nDecoderNum, NULL);
+}
+
+void CLisPipeline::DecodeLoop()
+{
+	while(true)
+	{
+		LISPipelineWait(this->hReadSem, &this->stats.nDecodeStall, &this->stats.lDecodeWait);
+		if(this->bAbort)
+			break;
+
+		int		nItem = (int)InterlockedIncrement(&this->nNextDecode) - 1;
+		if(nItem >= this->nItemNum)
+			break;
+
+		this->pDecodeProc(nItem, nItem % this->nDepth, this->pParam);
+		SetEvent(this->hDoneEventArr[nItem % this->nDepth]);
+	}
+}
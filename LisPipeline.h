@@ -0,0 +1,94 @@
+// LisPipeline.h: interface for the CLisPipeline class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#define		LIS_PIPELINE_DEPTH		16//So slot mac dinh giua cac cong doan
+
+//nItem: thu tu record trong pipeline, nSlot: slot chua du lieu cua record
+typedef void (*LISPipelineProc)(int nItem, int nSlot, void* pParam);
+
+//////////////////////////////////////////////////////////////////////
+// Dem so lan (va thoi gian, ms) moi cong doan phai cho:
+//  - Read:   doc xong nhung het slot trong (decode/ghi cham hon doc)
+//  - Decode: thread giai ma cho du lieu doc (doc file cham - I/O-bound)
+//  - Write:  thread ghi cho record giai ma xong (CPU-bound)
+//////////////////////////////////////////////////////////////////////
+class LISPipelineStats
+{
+public:
+	LONG	nReadStall;
+	LONG	nDecodeStall;
+	LONG	nWriteStall;
+	LONG	lReadWait;
+	LONG	lDecodeWait;
+	LONG	lWriteWait;
+	int		nItemNum;
+	int		nDecoderNum;
+	int		nDepth;
+public:
+	void Init()
+	{
+		nReadStall = 0;
+		nDecodeStall = 0;
+		nWriteStall = 0;
+		lReadWait = 0;
+		lDecodeWait = 0;
+		lWriteWait = 0;
+		nItemNum = 0;
+		nDecoderNum = 0;
+		nDepth = 0;
+	}
+	LISPipelineStats()
+	{
+		Init();
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// Pipeline 3 cong doan doc -> giai ma -> ghi voi hang doi gioi han
+// nDepth slot:
+//  - 1 thread doc goi pReadProc theo thu tu record,
+//  - nDecoderNum thread giai ma goi pDecodeProc,
+//  - thread goi ham lay ket qua theo dung thu tu: WaitItem(k) tra ve
+//    slot cua record k, ReleaseItem(k) tra slot cho thread doc.
+// Du lieu cua moi slot do nguoi goi cap phat (mang nDepth phan tu).
+//////////////////////////////////////////////////////////////////////
+class CLisPipeline
+{
+public:
+	LISPipelineStats	stats;
+protected:
+	LISPipelineProc		pReadProc;
+	LISPipelineProc		pDecodeProc;
+	void*				pParam;
+	int					nItemNum;
+	int					nDepth;
+	int					nDecoderNum;
+
+	HANDLE				hFreeSem;//Slot trong cho thread doc
+	HANDLE				hReadSem;//Record da doc cho thread giai ma
+	HANDLE*				hDoneEventArr;//Moi slot: record da giai ma xong
+	HANDLE*				hThreadArr;//Thread doc + cac thread giai ma
+	int					nThreadNum;
+
+	volatile LONG		nNextDecode;
+	volatile LONG		bAbort;
+public:
+	CLisPipeline();
+	~CLisPipeline();
+
+	bool	Start(int nItemNum, LISPipelineProc pReadProc, LISPipelineProc pDecodeProc, void* pParam,
+				int nDepth = LIS_PIPELINE_DEPTH, int nDecoderNum = 0);
+	int		WaitItem(int nItem);
+	void	ReleaseItem(int nItem);
+	void	Stop();
+
+	bool	IsRunning() const	{ return (hThreadArr != NULL); }
+protected:
+	static unsigned __stdcall ReadThreadProc(void* pArg);
+	static unsigned __stdcall DecodeThreadProc(void* pArg);
+	void	ReadLoop();
+	void	DecodeLoop();
+};
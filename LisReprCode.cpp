@@ -0,0 +1,396 @@
+// LisReprCode.cpp: implementation of the LISReprCode class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "LisReprCode.h"
+#include <math.h>
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+//////////////////////////////////////////////////////////////////////
+// Bang he so mu (2^n) tinh san, dung chung cho cac ham giai ma
+//////////////////////////////////////////////////////////////////////
+
+//Code 49: gia tri = mag * s_fScale49[S][E], mag = 11 bit (da bo dau)
+//  S=1 cho he so am de giu -0.0 nhu ReadReprCode (-(0 * 2^E))
+static double	s_fScale49[2][16];
+
+//Code 68: gia tri = M * s_fScale68[S][E], M co dau (int), he so luon duong
+//  S=0: 2^(E-128-23);  S=1: 2^(127-E-23)
+static double	s_fScale68[2][256];
+
+typedef void (*LISDecode68Proc)(const BYTE* pSrc, int nCount, float* pDst, bool bNegativeZero);
+
+static int				s_nCpuSimdLevel = LIS_SIMD_NONE;//Muc CPU ho tro
+static int				s_nSimdLevel = LIS_SIMD_NONE;//Muc dang dung
+static LISDecode68Proc	s_pDecode68 = NULL;
+
+static LISDecodeFloatProc	s_FloatProcs[256];
+static LISDecodeDoubleProc	s_DoubleProcs[256];
+static int					s_nCodeSize[256];
+
+//////////////////////////////////////////////////////////////////////
+// Cac ham giai ma theo tung ma (khong re nhanh theo tung mau)
+//////////////////////////////////////////////////////////////////////
+
+// REPRCODE_49 - 16 bit floating point
+template<class T> static void Decode49(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++, pSrc += 2)
+	{
+		unsigned int	nRaw = ((unsigned int)pSrc[0] << 4) | ((unsigned int)pSrc[1] >> 4);
+		unsigned int	S = (nRaw >> 11) & 1;
+		unsigned int	nMag = ((nRaw ^ (0u - S)) + S) & 0x7FF;
+		unsigned int	E = pSrc[1] & 0x0F;
+
+		pDst[i] = (T)((double)(int)nMag * s_fScale49[S][E]);
+	}
+}
+
+// REPRCODE_50 - 32 bit low resolution floating point (E 16 bit, M 16 bit)
+template<class T> static void Decode50(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++, pSrc += 4)
+	{
+		int		E = (short)(((unsigned int)pSrc[0] << 8) | (unsigned int)pSrc[1]);
+		int		M = (short)(((unsigned int)pSrc[2] << 8) | (unsigned int)pSrc[3]);
+
+		pDst[i] = (T)ldexp((double)M, E - 15);
+	}
+}
+
+// REPRCODE_56 - 8 bit integer
+template<class T> static void Decode56(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++)
+		pDst[i] = (T)(double)(signed char)pSrc[i];
+}
+
+// REPRCODE_66 - unsigned 8-bit integer
+template<class T> static void Decode66(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++)
+		pDst[i] = (T)(double)pSrc[i];
+}
+
+// REPRCODE_68 - 32-bit floating point
+template<class T> static void Decode68(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++, pSrc += 4)
+	{
+		unsigned int	nWord = ((unsigned int)pSrc[0] << 24) | ((unsigned int)pSrc[1] << 16) |
+								((unsigned int)pSrc[2] << 8) | (unsigned int)pSrc[3];
+		unsigned int	S = nWord >> 31;
+		unsigned int	E = (nWord >> 23) & 0xFF;
+		unsigned int	nMag = ((nWord ^ (0u - S)) + S) & 0x7FFFFF;
+		int				M = (int)((nMag ^ (0u - S)) + S);//-nMag neu am (M = 0 -> +0.0)
+
+		pDst[i] = (T)((double)M * s_fScale68[S][E]);
+	}
+}
+
+// REPRCODE_70 - 32 bit fix point
+template<class T> static void Decode70(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++, pSrc += 4)
+	{
+		unsigned int	nWord = ((unsigned int)pSrc[0] << 24) | ((unsigned int)pSrc[1] << 16) |
+								((unsigned int)pSrc[2] << 8) | (unsigned int)pSrc[3];
+
+		pDst[i] = (T)((int)nWord / 65536.0);
+	}
+}
+
+// REPRCODE_73 - 2's completement 32 bit integer
+template<class T> static void Decode73(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++, pSrc += 4)
+	{
+		unsigned int	nWord = ((unsigned int)pSrc[0] << 24) | ((unsigned int)pSrc[1] << 16) |
+								((unsigned int)pSrc[2] << 8) | (unsigned int)pSrc[3];
+
+		pDst[i] = (T)(double)(int)nWord;
+	}
+}
+
+// REPRCODE_79 - 2's completement 16-bit integer
+template<class T> static void Decode79(const BYTE* pSrc, int nCount, T* pDst)
+{
+	for(int i = 0; i < nCount; i++, pSrc += 2)
+		pDst[i] = (T)(double)(short)(((unsigned int)pSrc[0] << 8) | (unsigned int)pSrc[1]);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Ma 68 -> float: ban scalar va SIMD
+// Gia tri chinh xac |M| * 2^k duoc tinh bang double (khong sai so),
+// lam tron mot lan sang float, roi gan bit dau.
+//////////////////////////////////////////////////////////////////////
+
+static void Decode68Scalar(const BYTE* pSrc, int nCount, float* pDst, bool bNegativeZero)
+{
+	unsigned int	nNegZero = bNegativeZero ? 1 : 0;
+
+	for(int i = 0; i < nCount; i++, pSrc += 4)
+	{
+		unsigned int	nWord = ((unsigned int)pSrc[0] << 24) | ((unsigned int)pSrc[1] << 16) |
+								((unsigned int)pSrc[2] << 8) | (unsigned int)pSrc[3];
+		unsigned int	S = nWord >> 31;
+		unsigned int	E = (nWord >> 23) & 0xFF;
+		unsigned int	nMag = ((nWord ^ (0u - S)) + S) & 0x7FFFFF;
+		float			fValue = (float)((double)(int)nMag * s_fScale68[S][E]);
+		unsigned int	nBits;
+
+		memcpy(&nBits, &fValue, 4);
+		nBits |= (S & (nNegZero | (nMag != 0))) << 31;
+		memcpy(&pDst[i], &nBits, 4);
+	}
+}
+
+static void Decode68SSE2(const BYTE* pSrc, int nCount, float* pDst, bool bNegativeZero)
+{
+	const __m128i	nMask8 = _mm_set1_epi32(0xFF);
+	const __m128i	nMask16 = _mm_set1_epi32(0xFF00);
+	const __m128i	nMask24 = _mm_set1_epi32(0xFF0000);
+	const __m128i	nMaskM = _mm_set1_epi32(0x7FFFFF);
+	const __m128i	nBiasPos = _mm_set1_epi32(1023 - 128 - 23);//mu double = E + nBiasPos
+	const __m128i	nBiasNeg = _mm_set1_epi32(1023 + 127 - 23);//mu double = nBiasNeg - E
+	const __m128i	nSignBit = _mm_set1_epi32(0x80000000);
+	const __m128i	nZero = _mm_setzero_si128();
+	int				i = 0;
+
+	for(; i + 4 <= nCount; i += 4, pSrc += 16)
+	{
+		__m128i		w = _mm_loadu_si128((const __m128i*)pSrc);
+
+		//Big-endian -> little-endian
+		w = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(w, 24), _mm_srli_epi32(w, 24)),
+				_mm_or_si128(_mm_and_si128(_mm_slli_epi32(w, 8), nMask24),
+					_mm_and_si128(_mm_srli_epi32(w, 8), nMask16)));
+
+		__m128i		nNeg = _mm_srai_epi32(w, 31);
+		__m128i		E = _mm_and_si128(_mm_srli_epi32(w, 23), nMask8);
+		__m128i		nMag = _mm_and_si128(_mm_sub_epi32(_mm_xor_si128(w, nNeg), nNeg), nMaskM);
+		__m128i		nExp = _mm_or_si128(_mm_andnot_si128(nNeg, _mm_add_epi32(E, nBiasPos)),
+							_mm_and_si128(nNeg, _mm_sub_epi32(nBiasNeg, E)));
+
+		//He so 2^k dung truc tiep tu bit mu cua double
+		__m128d		fLo = _mm_mul_pd(_mm_cvtepi32_pd(nMag),
+							_mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(nExp, nZero), 52)));
+		__m128d		fHi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(nMag, nMag)),
+							_mm_castsi128_pd(_mm_slli_epi64(_mm_unpackhi_epi32(nExp, nZero), 52)));
+		__m128		fValue = _mm_movelh_ps(_mm_cvtpd_ps(fLo), _mm_cvtpd_ps(fHi));
+
+		__m128i		nSign = _mm_and_si128(nNeg, nSignBit);
+		if(!bNegativeZero)
+			nSign = _mm_andnot_si128(_mm_cmpeq_epi32(nMag, nZero), nSign);
+
+		_mm_storeu_ps(pDst + i, _mm_or_ps(fValue, _mm_castsi128_ps(nSign)));
+	}
+
+	Decode68Scalar(pSrc, nCount - i, pDst + i, bNegativeZero);
+}
+
+static void Decode68AVX2(const BYTE* pSrc, int nCount, float* pDst, bool bNegativeZero)
+{
+	const __m256i	nByteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+										3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	const __m256i	nMask8 = _mm256_set1_epi32(0xFF);
+	const __m256i	nMaskM = _mm256_set1_epi32(0x7FFFFF);
+	const __m256i	nBiasPos = _mm256_set1_epi32(1023 - 128 - 23);
+	const __m256i	nBiasNeg = _mm256_set1_epi32(1023 + 127 - 23);
+	const __m256i	nSignBit = _mm256_set1_epi32(0x80000000);
+	const __m256i	nZero = _mm256_setzero_si256();
+	int				i = 0;
+
+	for(; i + 8 <= nCount; i += 8, pSrc += 32)
+	{
+		__m256i		w = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)pSrc), nByteSwap);
+
+		__m256i		nNeg = _mm256_srai_epi32(w, 31);
+		__m256i		E = _mm256_and_si256(_mm256_srli_epi32(w, 23), nMask8);
+		__m256i		nMag = _mm256_and_si256(_mm256_sub_epi32(_mm256_xor_si256(w, nNeg), nNeg), nMaskM);
+		__m256i		nExp = _mm256_or_si256(_mm256_andnot_si256(nNeg, _mm256_add_epi32(E, nBiasPos)),
+							_mm256_and_si256(nNeg, _mm256_sub_epi32(nBiasNeg, E)));
+
+		__m256d		fLo = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(nMag)),
+							_mm256_castsi256_pd(_mm256_slli_epi64(
+								_mm256_cvtepu32_epi64(_mm256_castsi256_si128(nExp)), 52)));
+		__m256d		fHi = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(nMag, 1)),
+							_mm256_castsi256_pd(_mm256_slli_epi64(
+								_mm256_cvtepu32_epi64(_mm256_extracti128_si256(nExp, 1)), 52)));
+		__m256		fValue = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(fLo)),
+							_mm256_cvtpd_ps(fHi), 1);
+
+		__m256i		nSign = _mm256_and_si256(nNeg, nSignBit);
+		if(!bNegativeZero)
+			nSign = _mm256_andnot_si256(_mm256_cmpeq_epi32(nMag, nZero), nSign);
+
+		_mm256_storeu_ps(pDst + i, _mm256_or_ps(fValue, _mm256_castsi256_ps(nSign)));
+	}
+	_mm256_zeroupper();
+
+	Decode68SSE2(pSrc, nCount - i, pDst + i, bNegativeZero);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Ma 70 -> float: int32 -> float (lam tron mot lan) roi nhan 2^-16 (chinh xac)
+//////////////////////////////////////////////////////////////////////
+
+static void Decode70SSE2(const BYTE* pSrc, int nCount, float* pDst)
+{
+	const __m128i	nMask16 = _mm_set1_epi32(0xFF00);
+	const __m128i	nMask24 = _mm_set1_epi32(0xFF0000);
+	const __m128	fScale = _mm_set1_ps(1.0f / 65536.0f);
+	int				i = 0;
+
+	for(; i + 4 <= nCount; i += 4, pSrc += 16)
+	{
+		__m128i		w = _mm_loadu_si128((const __m128i*)pSrc);
+
+		w = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(w, 24), _mm_srli_epi32(w, 24)),
+				_mm_or_si128(_mm_and_si128(_mm_slli_epi32(w, 8), nMask24),
+					_mm_and_si128(_mm_srli_epi32(w, 8), nMask16)));
+
+		_mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(w), fScale));
+	}
+
+	Decode70<float>(pSrc, nCount - i, pDst + i);
+}
+
+static void Decode70Float(const BYTE* pSrc, int nCount, float* pDst)
+{
+	if(s_nSimdLevel >= LIS_SIMD_SSE2)
+		Decode70SSE2(pSrc, nCount, pDst);
+	else
+		Decode70<float>(pSrc, nCount, pDst);
+}
+
+//Ham dang ky trong bang (ngu nghia cua LISMisc::ReadReprCode)
+static void Decode68Float(const BYTE* pSrc, int nCount, float* pDst)
+{
+	s_pDecode68(pSrc, nCount, pDst, false);
+}
+
+//Kiem tra CPU: SSE2, AVX2 (ca CPU va he dieu hanh phai ho tro thanh ghi YMM)
+static int DetectSimdLevel()
+{
+	int		info[4];
+	int		nLevel = LIS_SIMD_NONE;
+
+	__cpuid(info, 0);
+	int		nMaxId = info[0];
+
+	__cpuid(info, 1);
+	if(info[3] & (1 << 26))
+		nLevel = LIS_SIMD_SSE2;
+
+	bool	bOSXSave = (info[2] & (1 << 27)) != 0;
+	bool	bAVX = (info[2] & (1 << 28)) != 0;
+	if(nLevel == LIS_SIMD_SSE2 && nMaxId >= 7 && bOSXSave && bAVX &&
+		(_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		if(info[1] & (1 << 5))
+			nLevel = LIS_SIMD_AVX2;
+	}
+
+	return nLevel;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Khoi tao bang (chay mot lan truoc main)
+//////////////////////////////////////////////////////////////////////
+
+static struct LISReprCodeTables
+{
+	LISReprCodeTables()
+	{
+		for(int E = 0; E < 16; E++)
+		{
+			s_fScale49[0][E] = ldexp(1.0, E - 11);
+			s_fScale49[1][E] = -ldexp(1.0, E - 11);
+		}
+		for(int E = 0; E < 256; E++)
+		{
+			s_fScale68[0][E] = ldexp(1.0, E - 128 - 23);
+			s_fScale68[1][E] = ldexp(1.0, 127 - E - 23);
+		}
+
+		memset(s_FloatProcs, 0, sizeof(s_FloatProcs));
+		memset(s_DoubleProcs, 0, sizeof(s_DoubleProcs));
+		memset(s_nCodeSize, 0, sizeof(s_nCodeSize));
+
+		Register(49, 2, Decode49<float>, Decode49<double>);
+		Register(50, 4, Decode50<float>, Decode50<double>);
+		Register(56, 1, Decode56<float>, Decode56<double>);
+		Register(66, 1, Decode66<float>, Decode66<double>);
+		Register(68, 4, Decode68Float, Decode68<double>);
+		Register(70, 4, Decode70Float, Decode70<double>);
+		Register(73, 4, Decode73<float>, Decode73<double>);
+		Register(79, 2, Decode79<float>, Decode79<double>);
+
+		s_nCpuSimdLevel = DetectSimdLevel();
+		LISReprCode::SetSimdLevel(s_nCpuSimdLevel);
+	}
+	void Register(int nReprCode, int nSize, LISDecodeFloatProc pFloat, LISDecodeDoubleProc pDouble)
+	{
+		s_FloatProcs[nReprCode] = pFloat;
+		s_DoubleProcs[nReprCode] = pDouble;
+		s_nCodeSize[nReprCode] = nSize;
+	}
+} s_reprCodeTables;
+
+//////////////////////////////////////////////////////////////////////
+// LISReprCode
+//////////////////////////////////////////////////////////////////////
+
+bool LISReprCode::IsBatchSupported(int nReprCode)
+{
+	if(nReprCode < 0 || nReprCode > 255)
+		return false;
+	return (s_FloatProcs[nReprCode] != NULL);
+}
+
+int LISReprCode::DecodeBatch(const BYTE* pSrc, int nReprCode, int nCount, float* pDst)
+{
+	if(!IsBatchSupported(nReprCode))
+		return 0;
+
+	s_FloatProcs[nReprCode](pSrc, nCount, pDst);
+	return nCount * s_nCodeSize[nReprCode];
+}
+
+int LISReprCode::DecodeBatch(const BYTE* pSrc, int nReprCode, int nCount, double* pDst)
+{
+	if(!IsBatchSupported(nReprCode))
+		return 0;
+
+	s_DoubleProcs[nReprCode](pSrc, nCount, pDst);
+	return nCount * s_nCodeSize[nReprCode];
+}
+
+void LISReprCode::Decode68(const BYTE* pSrc, int nCount, float* pDst, bool bNegativeZero)
+{
+	s_pDecode68(pSrc, nCount, pDst, bNegativeZero);
+}
+
+int LISReprCode::GetSimdLevel()
+{
+	return s_nSimdLevel;
+}
+
+void LISReprCode::SetSimdLevel(int nLevel)
+{
+	if(nLevel > s_nCpuSimdLevel)
+		nLevel = s_nCpuSimdLevel;
+
+	s_nSimdLevel = nLevel;
+	if(nLevel == LIS_SIMD_AVX2)
+		s_pDecode68 = Decode68AVX2;
+	else if(nLevel == LIS_SIMD_SSE2)
+		s_pDecode68 = Decode68SSE2;
+	else
+		s_pDecode68 = Decode68Scalar;
+}
@@ -0,0 +1,40 @@
+// LisReprCode.h: interface for the LISReprCode class.
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+//////////////////////////////////////////////////////////////////////
+// Giai ma hang loat (batch decode) nCount mau lien tiep cung mot ma
+// bieu dien (representation code) vao mang float/double.
+// Moi ma co mot ham rieng (49, 50, 56, 66, 68, 70, 73, 79), chon qua bang
+// con tro ham theo nReprCode. Ket qua trung tung bit voi
+// LISMisc::ReadReprCode (sau khi ep kieu double -> float).
+//
+// Ma 68 (so thuc 32 bit) co them nhanh SSE2/AVX2, ma 70 co nhanh SSE2,
+// chon luc chay theo CPU (GetSimdLevel).
+//////////////////////////////////////////////////////////////////////
+
+#define		LIS_SIMD_NONE		0
+#define		LIS_SIMD_SSE2		1
+#define		LIS_SIMD_AVX2		2
+
+typedef void (*LISDecodeFloatProc)(const BYTE* pSrc, int nCount, float* pDst);
+typedef void (*LISDecodeDoubleProc)(const BYTE* pSrc, int nCount, double* pDst);
+
+class LISReprCode
+{
+public:
+	static bool	IsBatchSupported(int nReprCode);
+
+	//Tra ve so byte da doc, 0 neu ma khong duoc ho tro (dung ReadReprCode)
+	static int	DecodeBatch(const BYTE* pSrc, int nReprCode, int nCount, float* pDst);
+	static int	DecodeBatch(const BYTE* pSrc, int nReprCode, int nCount, double* pDst);
+
+	//Ma 68 -> float IEEE. bNegativeZero = true: so am co phan dinh tri 0
+	//cho ra -0.0 (nhu CLisFile::ReadCode), false: +0.0 (nhu LISMisc::ReadReprCode)
+	static void	Decode68(const BYTE* pSrc, int nCount, float* pDst, bool bNegativeZero = false);
+
+	static int	GetSimdLevel();
+	static void	SetSimdLevel(int nLevel);//Gioi han muc SIMD (khong vuot qua muc CPU ho tro)
+};